@@ -0,0 +1,425 @@
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+#include <glob.h>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "SolverRegistry.h"
+
+/* Tunes the solver configuration per benchmark family by racing.
+ * A configuration is a heuristic plus search options, written as the
+ * "--option value" pairs the drivers take. The parameter space lists the
+ * candidate values of each option; random search draws configurations from
+ * it (the first draw is always the default one: every option's first value).
+ *
+ * The drawn configurations then race through a sample of the family's
+ * instances, one instance at a time: the surviving configurations solve it in
+ * parallel, one per worker thread, each run capped at the cutoff. A run costs
+ * its thread CPU seconds, or RACE_TIMEOUT_PENALTY times the cutoff if it does
+ * not finish (PAR2). Once every survivor has run RACE_MIN_INSTANCES
+ * instances, a configuration whose mean cost falls behind the leader's by
+ * more than RACE_ELIMINATION_FACTOR drops out, so losing configurations stop
+ * eating CPU early and the sample is spent on telling the good ones apart.
+ *
+ * The winner of each family is written to <output>/<family>.conf, which the
+ * drivers read back with --config.
+*/
+
+const int TUNE_DEFAULT_CONFIGURATIONS = 24;
+const int TUNE_DEFAULT_INSTANCES = 20;
+const double TUNE_DEFAULT_CUTOFF_SECONDS = 10;
+// configurations race this many instances before any of them is eliminated
+const int RACE_MIN_INSTANCES = 5;
+// a configuration whose mean cost exceeds the leader's by this factor, plus the slack, drops out
+const double RACE_ELIMINATION_FACTOR = 1.3;
+const double RACE_ELIMINATION_SLACK_SECONDS = 0.005;
+// an unfinished run costs this multiple of the cutoff
+const double RACE_TIMEOUT_PENALTY = 2;
+
+// "--option value" settings, applied in order on top of the defaults
+struct Configuration
+{
+    vector<pair<string, string>> settings;
+
+    // false if an option is neither --heuristic nor a budget or search option
+    bool apply(string& heuristic, SolverBudget& budget, SolverOptions& options) const {
+        for (int i = 0; i < settings.size(); i++) {
+            if (settings[i].first == "--heuristic") heuristic = settings[i].second;
+            else if (!parseSolveOption(settings[i].first, settings[i].second, budget, options)) return false;
+        }
+        return true;
+    }
+
+    string describe() const {
+        string description;
+        for (int i = 0; i < settings.size(); i++) {
+            description += (i == 0 ? "" : " ") + settings[i].first + " " + settings[i].second;
+        }
+        return description;
+    }
+
+    // one "--option value" per line; lines starting with 'c' or '#' are comments
+    bool read(const string& path) {
+        ifstream in(path);
+        if (!in) return false;
+        settings.clear();
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == 'c' || line[0] == '#') continue;
+            istringstream fields(line);
+            string option, value;
+            if (fields >> option >> value) settings.push_back({option, value});
+        }
+        return true;
+    }
+
+    bool write(const string& path, const string& comment) const {
+        ofstream out(path);
+        if (!out) return false;
+        out << "c " << comment << endl;
+        for (int i = 0; i < settings.size(); i++) out << settings[i].first << " " << settings[i].second << endl;
+        return true;
+    }
+};
+
+// candidate values of each option; the first value is the option's default
+struct ParameterSpace
+{
+    vector<pair<string, vector<string>>> parameters;
+
+    // the engines and search options worth trying on the bundled families
+    void setDefault() {
+        parameters = {
+            {"--heuristic", {"frequency-none-polarity", "vsids-mode-target", "vsids-mode-saved", "vsids-luby-saved",
+                             "lrb-luby-saved", "chb-luby-saved", "bandit-mode-target", "lookahead",
+                             "probsat+vsids-mode-target"}},
+            {"--modes", {"1000", "300", "3000", "-1"}},
+            {"--reduce", {"2000", "1000", "4000", "-1"}},
+            {"--vivify", {"2000", "500", "-1"}},
+            {"--vivify-effort", {"0.1", "0.05", "0.3"}},
+            {"--chrono", {"-1", "100"}},
+            {"--bce", {"0", "1"}},
+        };
+    }
+
+    /* one parameter per line: the option, then its values, default first,
+     * e.g. "--reduce 2000 1000 -1"; false (with a message on cerr) on a value
+     * the solvers would not take
+    */
+    bool read(const string& path) {
+        ifstream in(path);
+        if (!in) {
+            cerr << "cannot read parameter space " << path << endl;
+            return false;
+        }
+        parameters.clear();
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == 'c' || line[0] == '#') continue;
+            istringstream fields(line);
+            string option, value;
+            vector<string> values;
+            fields >> option;
+            while (fields >> value) values.push_back(value);
+            if (values.empty()) continue;
+            parameters.push_back({option, values});
+        }
+        return validate();
+    }
+
+    bool validate() const {
+        for (int p = 0; p < parameters.size(); p++) {
+            for (int v = 0; v < parameters[p].second.size(); v++) {
+                Configuration single;
+                single.settings.push_back({parameters[p].first, parameters[p].second[v]});
+                string heuristic;
+                SolverBudget budget;
+                SolverOptions options;
+                bool is_valid;
+                try {
+                    is_valid = single.apply(heuristic, budget, options) && (heuristic.empty() || createSolver(heuristic));
+                } catch (const exception&) {
+                    is_valid = false;
+                }
+                if (!is_valid) {
+                    cerr << "bad parameter value " << single.describe() << endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    Configuration defaultConfiguration() const {
+        Configuration configuration;
+        for (int p = 0; p < parameters.size(); p++) configuration.settings.push_back({parameters[p].first, parameters[p].second[0]});
+        return configuration;
+    }
+
+    Configuration sample(Xoshiro256& generator) const {
+        Configuration configuration;
+        for (int p = 0; p < parameters.size(); p++) {
+            const vector<string>& values = parameters[p].second;
+            configuration.settings.push_back({parameters[p].first, values[generator.below(values.size())]});
+        }
+        return configuration;
+    }
+};
+
+struct TuneParams
+{
+    // instance directories; empty tunes every testcase-* directory here
+    vector<string> families;
+    ParameterSpace space;
+    int num_configurations = TUNE_DEFAULT_CONFIGURATIONS;
+    int num_instances = TUNE_DEFAULT_INSTANCES;
+    double cutoff_seconds = TUNE_DEFAULT_CUTOFF_SECONDS;
+    int num_workers = max(1, (int) thread::hardware_concurrency());
+    uint64_t seed = 0;
+    string output_dir = ".";
+};
+
+class Autotuner
+{
+    struct Candidate
+    {
+        Configuration configuration;
+        string heuristic;
+        SolverBudget budget;
+        SolverOptions options;
+        double total_cost = 0;
+        int num_runs = 0;
+        bool is_racing = true;
+        // outcome of the latest run
+        double cost;
+        ReturnValue result;
+
+        double meanCost() const { return num_runs > 0 ? total_cost / num_runs : 0; }
+    };
+
+    // solvers of one worker thread by heuristic, kept warm from one instance to the next
+    typedef map<string, unique_ptr<SatSolver>> WorkerSolvers;
+
+    TuneParams params;
+    vector<WorkerSolvers> worker_solvers;
+    Xoshiro256 generator;
+
+    static double threadSeconds() {
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec + now.tv_nsec * 1e-9;
+    }
+
+    static vector<string> listFiles(const string& pattern) {
+        vector<string> paths;
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) paths.push_back(matches.gl_pathv[i]);
+        }
+        globfree(&matches);
+        return paths;
+    }
+
+    void runCandidate(WorkerSolvers& solvers, Candidate& candidate, const CNFFormula& formula, uint64_t seed);
+    void raceInstance(vector<Candidate>& candidates, const CNFFormula& formula, uint64_t seed);
+    int eliminateLosers(vector<Candidate>& candidates);
+    bool tuneFamily(const string& directory);
+
+public:
+    // tunes every family; false if one could not be tuned
+    bool run(const TuneParams& tune_params);
+};
+
+inline void Autotuner::runCandidate(WorkerSolvers& solvers, Candidate& candidate, const CNFFormula& formula, uint64_t seed) {
+    unique_ptr<SatSolver>& solver = solvers[candidate.heuristic];
+    if (!solver) solver = createSolver(candidate.heuristic);
+    double start = threadSeconds();
+    solver->setSeed(seed);
+    solver->setBudget(candidate.budget);
+    solver->setOptions(candidate.options);
+    solver->load(formula);
+    candidate.result = solver->search();
+    candidate.cost = threadSeconds() - start;
+    if (candidate.result == ReturnValue::unknown) candidate.cost = RACE_TIMEOUT_PENALTY * params.cutoff_seconds;
+    candidate.total_cost += candidate.cost;
+    candidate.num_runs++;
+}
+
+// every racing candidate solves the formula; worker threads take candidates off a shared counter
+inline void Autotuner::raceInstance(vector<Candidate>& candidates, const CNFFormula& formula, uint64_t seed) {
+    vector<int> racing;
+    for (int c = 0; c < candidates.size(); c++) {
+        if (candidates[c].is_racing) racing.push_back(c);
+    }
+    atomic<int> next_task(0);
+    auto work = [&](WorkerSolvers& solvers) {
+        for (int task = next_task++; task < racing.size(); task = next_task++) {
+            runCandidate(solvers, candidates[racing[task]], formula, seed);
+        }
+    };
+    vector<thread> threads;
+    int num_threads = min((int) racing.size(), params.num_workers);
+    for (int t = 1; t < num_threads; t++) threads.push_back(thread(work, ref(worker_solvers[t])));
+    work(worker_solvers[0]);
+    for (int t = 0; t < threads.size(); t++) threads[t].join();
+
+    // configurations must never disagree on an answer
+    int first_decided = -1;
+    for (int i = 0; i < racing.size(); i++) {
+        const Candidate& candidate = candidates[racing[i]];
+        if (candidate.result != ReturnValue::sat && candidate.result != ReturnValue::unsat) continue;
+        if (first_decided < 0) first_decided = racing[i];
+        else if (candidate.result != candidates[first_decided].result) {
+            cerr << "configurations disagree: " << candidates[first_decided].configuration.describe()
+                 << " and " << candidate.configuration.describe() << endl;
+        }
+    }
+}
+
+// returns the number of candidates dropped
+inline int Autotuner::eliminateLosers(vector<Candidate>& candidates) {
+    double best_mean = INFINITY;
+    for (int c = 0; c < candidates.size(); c++) {
+        if (!candidates[c].is_racing) continue;
+        if (candidates[c].num_runs < RACE_MIN_INSTANCES) return 0;
+        best_mean = min(best_mean, candidates[c].meanCost());
+    }
+    int num_eliminated = 0;
+    for (int c = 0; c < candidates.size(); c++) {
+        if (candidates[c].is_racing && candidates[c].meanCost() > RACE_ELIMINATION_FACTOR * best_mean + RACE_ELIMINATION_SLACK_SECONDS) {
+            candidates[c].is_racing = false;
+            num_eliminated++;
+        }
+    }
+    return num_eliminated;
+}
+
+inline bool Autotuner::tuneFamily(const string& directory) {
+    string family = directory;
+    while (!family.empty() && family.back() == '/') family.pop_back();
+    family = family.substr(family.find_last_of('/') + 1);
+    vector<string> instances = listFiles(directory + "/*.cnf");
+    if (instances.empty()) {
+        cerr << "no .cnf files in " << directory << endl;
+        return false;
+    }
+    // a random sample of the family, the same for every configuration
+    for (int i = instances.size() - 1; i > 0; i--) swap(instances[i], instances[generator.below(i + 1)]);
+    instances.resize(min((int) instances.size(), params.num_instances));
+
+    // random search: the default configuration, then distinct random draws
+    vector<Candidate> candidates;
+    vector<string> drawn;
+    Configuration configuration = params.space.defaultConfiguration();
+    for (int attempt = 0; candidates.size() < params.num_configurations && attempt < 100 * params.num_configurations; attempt++) {
+        string description = configuration.describe();
+        if (find(drawn.begin(), drawn.end(), description) == drawn.end()) {
+            drawn.push_back(description);
+            Candidate candidate;
+            candidate.configuration = configuration;
+            candidate.heuristic = "frequency-none-polarity";
+            configuration.apply(candidate.heuristic, candidate.budget, candidate.options);
+            candidate.budget.max_seconds = params.cutoff_seconds;
+            candidates.push_back(candidate);
+        }
+        configuration = params.space.sample(generator);
+    }
+    cout << "c " << family << ": racing " << candidates.size() << " configurations on "
+         << instances.size() << " instances" << endl;
+
+    CNFFormula formula;
+    int num_racing = candidates.size();
+    for (int i = 0; i < instances.size() && num_racing > 1 && !interrupt_signalled; i++) {
+        ifstream in(instances[i]);
+        readDimacs(in, formula);
+        raceInstance(candidates, formula, params.seed + i);
+        int num_eliminated = eliminateLosers(candidates);
+        num_racing -= num_eliminated;
+        cout << "c " << family << " instance " << i + 1 << ": " << num_racing << " racing";
+        if (num_eliminated > 0) cout << ", " << num_eliminated << " eliminated";
+        cout << endl;
+    }
+
+    // the leader among the survivors, which have all run the same instances
+    int best = -1;
+    for (int c = 0; c < candidates.size(); c++) {
+        if (candidates[c].is_racing && (best < 0 || candidates[c].meanCost() < candidates[best].meanCost())) best = c;
+    }
+    const Candidate& winner = candidates[best];
+    const Candidate& default_candidate = candidates[0];
+    ostringstream summary;
+    summary << "tuned on " << winner.num_runs << " instances of " << family << ": " << winner.meanCost()
+            << " s mean, default " << default_candidate.meanCost() << " s over " << default_candidate.num_runs;
+    cout << "c " << summary.str() << endl;
+    cout << "c best: " << winner.configuration.describe() << endl;
+
+    string path = params.output_dir + "/" + family + ".conf";
+    if (!winner.configuration.write(path, summary.str())) {
+        cerr << "cannot write " << path << endl;
+        return false;
+    }
+    cout << "c written to " << path << endl;
+    return true;
+}
+
+inline bool Autotuner::run(const TuneParams& tune_params) {
+    params = tune_params;
+    params.num_workers = max(1, params.num_workers);
+    generator.setSeed(params.seed);
+    // also fills the solver registry before any worker thread looks a name up
+    if (!params.space.validate()) return false;
+    worker_solvers = vector<WorkerSolvers>(params.num_workers);
+
+    vector<string> families = params.families;
+    if (families.empty()) families = listFiles("testcase-*");
+    if (families.empty()) {
+        cerr << "no families to tune" << endl;
+        return false;
+    }
+    bool is_complete = true;
+    for (int f = 0; f < families.size() && !interrupt_signalled; f++) {
+        is_complete = tuneFamily(families[f]) && is_complete;
+    }
+    return is_complete;
+}
+
+/* "tune [options] [FAMILY_DIR ...]": tunes each directory of .cnf files
+ * (default: every testcase-* directory here) and writes <family>.conf.
+ * options: --configurations N (random draws, default included),
+ * --instances N (sampled per family), --cutoff SECONDS (per run),
+ * --workers N (threads, default one per core), --seed N,
+ * --space FILE (parameter space, one "--option default other ..." per line),
+ * --output DIR (where the .conf files go)
+*/
+inline int runTuner(int argc, char* argv[]) {
+    TuneParams params;
+    params.space.setDefault();
+    for (int i = 2; i < argc; i++) {
+        string option = argv[i];
+        if (option.compare(0, 2, "--") != 0) {
+            params.families.push_back(option);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "missing value for " << option << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        if (option == "--configurations") params.num_configurations = stoi(value);
+        else if (option == "--instances") params.num_instances = stoi(value);
+        else if (option == "--cutoff") params.cutoff_seconds = stod(value);
+        else if (option == "--workers") params.num_workers = stoi(value);
+        else if (option == "--seed") params.seed = stoull(value);
+        else if (option == "--output") params.output_dir = value;
+        else if (option == "--space") {
+            if (!params.space.read(value)) return 1;
+        } else cerr << "ignoring unknown option " << option << endl;
+    }
+    // Ctrl-C stops the race in progress and writes its current leader
+    signal(SIGINT, handleInterruptSignal);
+    Autotuner tuner;
+    return tuner.run(params) ? 0 : 1;
+}
+
+#endif
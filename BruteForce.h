@@ -0,0 +1,333 @@
+#ifndef BRUTE_FORCE_H
+#define BRUTE_FORCE_H
+
+#include <memory>
+#include "SolverCommon.h"
+
+/* Exhaustive search for tiny formulas using bit-parallel truth tables.
+ * Bit i of a block stands for one assignment: the lowest variables take their
+ * value from the bit position, the remaining "high" variables from the block
+ * index. A variable then becomes a fixed bit pattern, a clause the OR of the
+ * patterns of its literals, and the formula the AND of its clauses, so one
+ * instruction checks a whole block of assignments.
+ *
+ * Blocks are 64 bits wide (scalar fallback), 256 bits (AVX2) or 512 bits
+ * (AVX-512), picked at runtime from what the CPU supports.
+*/
+
+// formulas with more variables are left to the other engines
+const int MAX_BRUTE_FORCE_VARIABLES = 30;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BRUTE_FORCE_HAS_SIMD 1
+#define BRUTE_FORCE_INLINE inline __attribute__((always_inline))
+typedef uint64_t Bits256 __attribute__((vector_size(32)));
+typedef uint64_t Bits512 __attribute__((vector_size(64)));
+#else
+#define BRUTE_FORCE_INLINE inline
+#endif
+
+// a clause split into literals on block-position variables and literals on block-index variables
+struct BruteForceClause
+{
+    vector<Lit> low_literals;
+    vector<Lit> high_literals;
+};
+
+// block of Words 64-bit words; Block is uint64_t or a GCC vector type of that many words
+template <class Block, int Words>
+struct BitBlockOps
+{
+    static const int LOW_VARIABLES = (Words == 1) ? 6 : (Words == 4) ? 8 : 9;
+
+    // blocks are passed by reference only: returning a vector type by value
+    // from code not compiled for its instruction set changes the ABI
+    BRUTE_FORCE_INLINE static void fill(Block& block, uint64_t value) {
+        for (int w = 0; w < Words; w++) setWord(block, w, value);
+    }
+
+    BRUTE_FORCE_INLINE static uint64_t word(const Block& block, int w) {
+        return ((const uint64_t*) &block)[w];
+    }
+
+    BRUTE_FORCE_INLINE static void setWord(Block& block, int w, uint64_t value) {
+        ((uint64_t*) &block)[w] = value;
+    }
+
+    BRUTE_FORCE_INLINE static bool isZero(const Block& block) {
+        uint64_t any = 0;
+        for (int w = 0; w < Words; w++) any |= word(block, w);
+        return any == 0;
+    }
+
+    // truth table of a literal on a block-position variable
+    static void variablePattern(Block& block, int variable, bool is_negative) {
+        static const uint64_t in_word_patterns[6] = {
+            0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+            0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+        };
+        for (int w = 0; w < Words; w++) {
+            // variables 6 and up select whole words
+            uint64_t value = (variable < 6) ? in_word_patterns[variable]
+                : (((w >> (variable - 6)) & 1) ? ~0ULL : 0ULL);
+            setWord(block, w, is_negative ? ~value : value);
+        }
+    }
+};
+
+/* what stops a scan early: an interrupt, or running out of the budget. Blocks
+ * count against max_blocks (the propagation budget), and memory is all
+ * allocated before the scan starts, so memory_mb is measured once.
+*/
+struct BruteForceLimits
+{
+    const atomic<bool>* stop_requested;
+    chrono::steady_clock::time_point deadline;
+    bool has_deadline = false;
+    long long max_blocks = -1;
+    double memory_mb = 0;
+    long long max_memory_mb = -1;
+
+    bool isReached(long long scanned_blocks) const {
+        if (stop_requested->load(memory_order_relaxed) || interrupt_signalled) return true;
+        if (max_blocks >= 0 && scanned_blocks >= max_blocks) return true;
+        if (max_memory_mb >= 0 && memory_mb >= max_memory_mb) return true;
+        return has_deadline && chrono::steady_clock::now() >= deadline;
+    }
+};
+
+/* scans blocks [0, num_blocks) and returns the index of the first assignment
+ * satisfying all clauses, -1 if there is none and -2 when interrupted or out
+ * of budget.
+ * Always inlined, so the loop is compiled with the instruction set of the
+ * bruteForceScanBlocks overload it lands in.
+*/
+template <class Block, int Words>
+BRUTE_FORCE_INLINE long long bruteForceScan(
+    const vector<BruteForceClause>& clauses, const Block* literal_patterns,
+    const Block& base_result, long long num_blocks, const BruteForceLimits& limits) {
+    typedef BitBlockOps<Block, Words> Ops;
+    for (long long b = 0; b < num_blocks; b++) {
+        // cheap enough to poll every few thousand blocks
+        if ((b & 4095) == 0 && limits.isReached(b)) return -2;
+        Block result = base_result;
+        Block clause_mask = Block();
+        for (int c = 0; c < clauses.size(); c++) {
+            const BruteForceClause& clause = clauses[c];
+            // a true literal on a block-index variable satisfies the clause for the whole block
+            bool satisfied_by_block = false;
+            for (int k = 0; k < clause.high_literals.size(); k++) {
+                Lit literal = clause.high_literals[k];
+                int bit = literalVariable(literal) - Ops::LOW_VARIABLES;
+                if (((b >> bit) & 1) != isNegativeLiteral(literal)) {
+                    satisfied_by_block = true;
+                    break;
+                }
+            }
+            if (satisfied_by_block) continue;
+            clause_mask = Block();
+            for (int k = 0; k < clause.low_literals.size(); k++) {
+                clause_mask |= literal_patterns[clause.low_literals[k]];
+            }
+            result &= clause_mask;
+            if (Ops::isZero(result)) break;
+        }
+        if (!Ops::isZero(result)) {
+            for (int w = 0; w < Words; w++) {
+                uint64_t bits = Ops::word(result, w);
+                if (bits != 0) {
+                    int bit = 0;
+                    while (((bits >> bit) & 1) == 0) bit++;
+                    return (b << Ops::LOW_VARIABLES) | ((long long) w << 6) | bit;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+inline long long bruteForceScanBlocks(const vector<BruteForceClause>& clauses, const uint64_t* literal_patterns,
+    const uint64_t& base_result, long long num_blocks, const BruteForceLimits& limits) {
+    return bruteForceScan<uint64_t, 1>(clauses, literal_patterns, base_result, num_blocks, limits);
+}
+
+#ifdef BRUTE_FORCE_HAS_SIMD
+// only called after __builtin_cpu_supports confirmed the instruction set
+__attribute__((target("avx2"))) inline long long bruteForceScanBlocks(const vector<BruteForceClause>& clauses,
+    const Bits256* literal_patterns, const Bits256& base_result, long long num_blocks, const BruteForceLimits& limits) {
+    return bruteForceScan<Bits256, 4>(clauses, literal_patterns, base_result, num_blocks, limits);
+}
+
+__attribute__((target("avx512f"))) inline long long bruteForceScanBlocks(const vector<BruteForceClause>& clauses,
+    const Bits512* literal_patterns, const Bits512& base_result, long long num_blocks, const BruteForceLimits& limits) {
+    return bruteForceScan<Bits512, 8>(clauses, literal_patterns, base_result, num_blocks, limits);
+}
+#endif
+
+class BruteForceSolver : public SatSolver
+{
+    int num_variables;
+    bool has_empty_clause;
+    vector<vector<Lit>> clauses;
+    vector<char> model;
+    SolverStatistics statistics;
+    SolverBudget budget;
+    BruteForceLimits limits;
+    atomic<bool> interrupt_requested{false};
+
+    // split the clauses for the given block width, AND together the ones that
+    // only use block-position variables, then scan the blocks
+    template <class Block, int Words>
+    long long scanWithBlock();
+
+public:
+    void load(const CNFFormula& formula);
+    ReturnValue search();
+    int numVariables() { return num_variables; }
+    bool modelValue(int variable) { return model[variable]; }
+    // time, memory and propagations (one per block of assignments) apply; there are no conflicts
+    void setBudget(const SolverBudget& new_budget) { budget = new_budget; }
+    void setSeed(uint64_t) {}
+    void interrupt() { interrupt_requested.store(true, memory_order_relaxed); }
+    const SolverStatistics& getStatistics() { return statistics; }
+};
+
+inline void BruteForceSolver::load(const CNFFormula& formula) {
+    num_variables = formula.num_variables;
+    has_empty_clause = false;
+    clauses.resize(formula.numClauses());
+    for (int c = 0; c < formula.numClauses(); c++) {
+        clauses[c].assign(formula.clauseLiterals(c), formula.clauseLiterals(c) + formula.clauseSize(c));
+        if (clauses[c].empty()) has_empty_clause = true;
+    }
+    model.assign(num_variables, 0);
+}
+
+template <class Block, int Words>
+long long BruteForceSolver::scanWithBlock() {
+    typedef BitBlockOps<Block, Words> Ops;
+    vector<Block> literal_patterns(2 * Ops::LOW_VARIABLES);
+    for (int v = 0; v < Ops::LOW_VARIABLES; v++) {
+        Ops::variablePattern(literal_patterns[makeLiteral(v, false)], v, false);
+        Ops::variablePattern(literal_patterns[makeLiteral(v, true)], v, true);
+    }
+
+    Block base_result;
+    Ops::fill(base_result, ~0ULL);
+    vector<BruteForceClause> mixed_clauses;
+    for (int c = 0; c < clauses.size(); c++) {
+        BruteForceClause split;
+        for (int k = 0; k < clauses[c].size(); k++) {
+            if (literalVariable(clauses[c][k]) < Ops::LOW_VARIABLES) split.low_literals.push_back(clauses[c][k]);
+            else split.high_literals.push_back(clauses[c][k]);
+        }
+        if (split.high_literals.empty()) {
+            // same mask for every block: apply it once
+            Block clause_mask = Block();
+            for (int k = 0; k < split.low_literals.size(); k++) clause_mask |= literal_patterns[split.low_literals[k]];
+            base_result &= clause_mask;
+        } else {
+            mixed_clauses.push_back(split);
+        }
+    }
+    if (Ops::isZero(base_result)) return -1;
+
+    long long num_blocks = (num_variables > Ops::LOW_VARIABLES) ? 1LL << (num_variables - Ops::LOW_VARIABLES) : 1;
+    statistics.propagations = num_blocks;
+    return bruteForceScanBlocks(mixed_clauses, literal_patterns.data(), base_result, num_blocks, limits);
+}
+
+inline ReturnValue BruteForceSolver::search() {
+    statistics = SolverStatistics();
+    interrupt_requested.store(false, memory_order_relaxed);
+    chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+    if (has_empty_clause) return ReturnValue::unsat;
+    if (num_variables > MAX_BRUTE_FORCE_VARIABLES) return ReturnValue::unknown;
+
+    size_t num_literals = 0;
+    for (int c = 0; c < clauses.size(); c++) num_literals += clauses[c].size();
+    // the clauses, split once more for the scan, plus the model
+    statistics.memory_mb = (2.0 * num_literals * sizeof(Lit) + 2.0 * clauses.size() * sizeof(vector<Lit>)
+        + num_variables) / (1024.0 * 1024.0);
+    limits = BruteForceLimits();
+    limits.stop_requested = &interrupt_requested;
+    limits.has_deadline = budget.max_seconds >= 0;
+    if (limits.has_deadline) {
+        limits.deadline = start_time + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(budget.max_seconds));
+    }
+    limits.max_blocks = budget.max_propagations;
+    limits.memory_mb = statistics.memory_mb;
+    limits.max_memory_mb = budget.max_memory_mb;
+
+    long long assignment;
+#ifdef BRUTE_FORCE_HAS_SIMD
+    // wider blocks only pay off once there are enough variables to fill them
+    if (num_variables > 8 && __builtin_cpu_supports("avx512f")) {
+        assignment = scanWithBlock<Bits512, 8>();
+    } else if (num_variables > 6 && __builtin_cpu_supports("avx2")) {
+        assignment = scanWithBlock<Bits256, 4>();
+    } else {
+        assignment = scanWithBlock<uint64_t, 1>();
+    }
+#else
+    assignment = scanWithBlock<uint64_t, 1>();
+#endif
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start_time;
+    statistics.seconds = elapsed.count();
+    if (assignment == -2) return ReturnValue::unknown;
+    if (assignment == -1) return ReturnValue::unsat;
+    for (int v = 0; v < num_variables; v++) {
+        model[v] = (assignment >> v) & 1;
+    }
+    return ReturnValue::sat;
+}
+
+/* brute force for formulas with at most MAX_BRUTE_FORCE_VARIABLES variables,
+ * the given solver for everything bigger
+*/
+class SmallInstanceDispatchSolver : public SatSolver
+{
+    BruteForceSolver brute_force;
+    unique_ptr<SatSolver> large_instance_solver;
+    bool use_brute_force;
+
+    SatSolver& active() {
+        if (use_brute_force) return brute_force;
+        return *large_instance_solver;
+    }
+
+public:
+    explicit SmallInstanceDispatchSolver(unique_ptr<SatSolver> solver)
+        : large_instance_solver(move(solver)), use_brute_force(false) {}
+
+    void load(const CNFFormula& formula) {
+        use_brute_force = formula.num_variables <= MAX_BRUTE_FORCE_VARIABLES;
+        active().load(formula);
+    }
+
+    void reset() { large_instance_solver->reset(); }
+
+    ReturnValue search() { return active().search(); }
+    int numVariables() { return active().numVariables(); }
+    bool modelValue(int variable) { return active().modelValue(variable); }
+    void suggestPhase(int variable, bool is_negative) { active().suggestPhase(variable, is_negative); }
+    void suggestAssignment(const vector<Lit>& literals) { active().suggestAssignment(literals); }
+
+    void setBudget(const SolverBudget& new_budget) {
+        brute_force.setBudget(new_budget);
+        large_instance_solver->setBudget(new_budget);
+    }
+
+    void setOptions(const SolverOptions& new_options) { large_instance_solver->setOptions(new_options); }
+    void setSeed(uint64_t seed) { large_instance_solver->setSeed(seed); }
+
+    void interrupt() {
+        brute_force.interrupt();
+        large_instance_solver->interrupt();
+    }
+
+    const SolverStatistics& getStatistics() { return active().getStatistics(); }
+};
+
+#endif
@@ -0,0 +1,1851 @@
+#ifndef CDCL_SOLVER_H
+#define CDCL_SOLVER_H
+
+#include "SolverCommon.h"
+#include "ClauseElimination.h"
+#include "ProofLogging.h"
+#include "Checkpoint.h"
+#include <unordered_map>
+#include <unordered_set>
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+// offset of a clause in clause_arena (of its size word, for clauses that have one)
+typedef unsigned int ClauseRef;
+
+// clause field of a watcher that stands for a whole binary clause
+const ClauseRef BINARY_CLAUSE = UINT_MAX;
+
+// triggering clause of a variable forced by a binary clause
+const int BINARY_REASON = -2;
+
+/* entry of a watch list. blocker is another literal of the clause: while it
+ * is true the clause is satisfied and is skipped without reading clause_arena.
+ * A binary clause is stored entirely in its two watchers, with clause set to
+ * BINARY_CLAUSE and blocker holding the other literal.
+*/
+struct Watcher
+{
+    ClauseRef clause;
+    Lit blocker;
+};
+
+/* flags of the header word stored in front of the size word of a sized clause;
+ * the remaining low bits hold its literal block distance (its size for input clauses)
+*/
+const Lit CLAUSE_LEARNED = 1u << 31;
+const Lit CLAUSE_USED = 1u << 30;       // took part in conflict analysis since the last reduction
+const Lit CLAUSE_VIVIFIED = 1u << 29;   // went through vivification without getting shorter
+const Lit CLAUSE_LIVE = 1u << 28;       // set by garbage collection on clauses still in formula
+const Lit CLAUSE_RELOCATED = 1u << 27;  // moved by garbage collection; the size word holds the new offset
+const Lit CLAUSE_LBD_MASK = CLAUSE_RELOCATED - 1;
+
+// learned clauses with at most this LBD are never deleted and are laid out first by garbage collection
+const int CORE_CLAUSE_LBD = 2;
+// each learned clause reduction comes this many conflicts later than the previous one
+const long long REDUCE_INTERVAL_INCREMENT = 300;
+
+// LRAT: key of a binary clause in binary_clause_ids, the same for either literal order
+inline uint64_t binaryClauseKey(Lit first, Lit second) {
+    if (first > second) swap(first, second);
+    return ((uint64_t) first << 32) | second;
+}
+
+// hint the next clause of a watch list into cache while the current one is inspected
+#if defined(_MSC_VER)
+#define PREFETCH_CLAUSE(address) _mm_prefetch((const char*) (address), _MM_HINT_T0)
+#else
+#define PREFETCH_CLAUSE(address) __builtin_prefetch(address)
+#endif
+
+/* CDCL search, specialized at compile time on three policies (see SolverPolicies.h):
+ * Branching picks the next decision variable, Restart decides when to restart,
+ * Phase picks the polarity of a decision. All policy calls are direct and get
+ * inlined into the search loop; a prebuilt instantiation is chosen by name
+ * through SolverRegistry.h.
+*/
+template <class Branching, class Restart, class Phase>
+class CDCLSolver : public SatSolver
+{
+    /* current value of every literal, indexed by packed literal;
+     * both polarities of a variable are kept in sync so checking whether
+     * a literal is false is one load and one compare
+     * LIT_UNASSIGNED: unassigned
+     * LIT_FALSE : literal is false
+     * LIT_TRUE : literal is true
+    */
+    vector<signed char> literal_values;
+
+    /* clause memory: each clause of 3 or more literals is stored inline as
+     * [header][size][literal 0][literal 1]..., literals 0 and 1 being the watched
+     * ones, and is referred to by the offset of its size word.
+     * When every input clause has the same width, the input clauses are instead
+     * packed at the front as [literal 0]...[literal width-1] with no header or size
+     * word, up to fixed_clause_end; learned clauses always use the sized layout.
+     * Binary clauses never get an entry here.
+     * Deleted clauses stay until collectGarbage() compacts the arena.
+    */
+    vector<Lit> clause_arena;
+    // the previous arena, kept for its capacity: clause_arena is rebuilt into it and swapped
+    vector<Lit> spare_arena;
+    int fixed_clause_width;      // width of the packed input clauses, 0 if not packed
+    ClauseRef fixed_clause_end;  // clauses below this offset are packed fixed-width ones
+
+    // every clause of clause_arena that is not deleted: the given 3CNF and learned clauses
+    vector<ClauseRef> formula;
+
+    // watches[literal]: clauses watching that literal, inspected when it becomes false
+    vector<vector<Watcher>> watches;
+
+    // unit clauses of the input, asserted at level 0 when solving starts
+    vector<Lit> unit_clauses;
+    bool has_empty_clause;  // input contained an empty clause
+
+    // blocked/covered clause elimination, and what is needed to extend its models
+    ClauseEliminator clause_eliminator;
+    bool is_preprocessed;
+
+    // proof of unsatisfiability, written during search when options.proof_path is set
+    ProofWriter proof;
+    /* LRAT clause ids, tracked from load() on when the options ask for an LRAT proof.
+     * Input clause i has id i + 1; every clause added to the proof takes the next id.
+    */
+    bool is_tracking_ids;
+    uint64_t next_clause_id;
+    vector<uint64_t> clause_ids;                           // indexed by ClauseRef
+    unordered_map<uint64_t, uint64_t> binary_clause_ids;   // by binaryClauseKey
+    vector<uint64_t> unit_clause_ids;   // per variable: its level 0 unit clause, 0 until there is one
+    vector<uint64_t> input_unit_ids;    // parallel to unit_clauses
+    uint64_t empty_clause_id;
+    vector<uint64_t> proof_hints;
+
+    // snapshots of the search for options.checkpoint_path, and resuming from options.resume_path
+    SnapshotWriter checkpoint_writer;
+    uint64_t formula_hash;       // of the loaded formula, if a checkpoint option was set at load()
+    bool has_tried_resume;       // the snapshot, if any, was already imported since load()
+    uint64_t resumed_conflicts;  // conflicts of the runs the imported snapshot came from
+    long long next_checkpoint_check;
+    chrono::steady_clock::time_point next_checkpoint_time;
+    vector<double> snapshot_scores;
+
+    // from suggestAssignment(): the first decisions of a search, until a conflict shows them wrong
+    vector<Lit> hint_literals;
+    int next_hint;
+
+    // number of occurrences of each variable in the input
+    vector<int> variable_occurrences;
+    // the input clause load() is adding
+    vector<Lit> input_clause;
+
+    // difference between number of true literals and false literals
+    vector<int> literal_polarity_difference;
+
+    // stores for each variable which level in CDCL it is assigned
+    vector<int> variable_assignment_decision_level;
+
+    // marks the clause that forced this assignment
+    // if variable is picked, mark -1 instead; BINARY_REASON if a binary clause forced it
+    vector<int> variable_assignment_triggering_clause;
+
+    // for BINARY_REASON assignments, the other (false) literal of the binary clause
+    vector<Lit> variable_binary_reason;
+
+    // assigned literals in assignment order
+    vector<Lit> trail;
+    /* trail_level_start[d] is the trail size when decision level d + 1 began.
+     * With chronological backtracking the trail is not sorted by level: a
+     * literal implied by lower-level literals gets that lower level even when
+     * it is pushed later, and backtracking keeps such literals.
+    */
+    vector<int> trail_level_start;
+    // trail position of the next literal whose watches must be inspected
+    int propagation_head;
+
+    // per-variable marks used during conflict analysis
+    vector<char> seen;
+    // per-level marks for counting the levels of a learned clause
+    vector<int> level_stamp;
+    int current_level_stamp;
+
+    // focused/stable mode state, used when a policy has_modes
+    bool stable_mode;
+    int num_mode_switches;
+    // watchers visited by propagation, a machine-independent measure of work
+    long long propagation_ticks;
+    long long first_mode_ticks;
+    // conflict count, or tick count with mode_switch_by_ticks, at which the mode ends
+    long long next_mode_switch;
+
+    // conflict count at which the next vivification round is due
+    long long next_vivification;
+    // propagation_ticks when the last vivification round ended
+    long long last_vivification_ticks;
+    // off while vivification assigns literals, so its trial assignments do not become saved phases
+    bool save_phases;
+
+    // conflict count at which learned clauses are next reduced, and how many reductions ran
+    long long next_reduction;
+    int num_reductions;
+
+    int num_clauses;        // number of clauses
+    int num_variables;      // total number of variables
+    int num_assigned;       // number of variables currently assigned
+    int conflict_clause_number;    // clause that is found unsat, to be recorded for learning
+    Lit conflict_binary_clause[2]; // literals of the conflict when conflict_clause_number is BINARY_REASON
+    long long num_formula_literals; // total literals over all clauses, for the memory budget
+
+    SolverBudget budget;
+    SolverOptions options;
+    SolverStatistics statistics;
+    chrono::steady_clock::time_point solve_start_time;
+    // set by interrupt(), possibly from another thread
+    atomic<bool> interrupt_requested{false};
+
+    Branching branching;
+    Restart restarts;
+    Phase phases;
+    uint64_t random_seed = 0;
+
+    ReturnValue runCDCL();
+    ReturnValue UnitPropagation(int decision_level);
+    template <int FixedWidth> ReturnValue propagateWatches(int decision_level);
+    Lit pickBranchingVariable();
+    void assignLiteral(Lit literal_to_make_true, int decision_level, int triggering_clause);
+    void unassignVariable(int variable_to_unassign);
+    void backtrack(int decision_level_to_backtrack);
+    int learnConflictAndBacktrack(int decision_level);
+    int findConflictLevel(Lit& forced_literal, int& num_literals_at_conflict_level);
+    void moveWatch(ClauseRef clause, Lit from, Lit to, Lit blocker);
+    void removeWatch(Lit literal, ClauseRef clause);
+    bool vivifyClauses();
+    void vivifyLiterals(ClauseRef clause, vector<Lit>& vivified, bool& is_satisfied);
+    bool isModeSwitchDue();
+    void switchMode();
+    void addClause(vector<Lit>& clause, uint64_t id);
+    void addBinaryClause(Lit first, Lit second, uint64_t id = 0);
+    ClauseRef allocateClause(const vector<Lit>& clause, bool learned, int lbd, uint64_t id = 0);
+    const Lit* reasonLiterals(int variable, int& size, Lit* binary_literals);
+    uint64_t reasonClauseId(int variable);
+    uint64_t unitClauseId(int variable);
+    void collectImplicationHints(const Lit* literals, int size, int skipped_variable, uint64_t clause_id);
+    uint64_t logAddedClause(const Lit* literals, int size);
+    void logDeletedClause(ClauseRef clause);
+    void logEmptyClause(const Lit* literals, int size, uint64_t clause_id);
+    ReturnValue refuteFromConflict();
+    void writeCheckpoint(bool is_final);
+    void resumeFromSnapshot();
+    void applyHints();
+    Lit pickHintedLiteral();
+    Lit clauseHeader(ClauseRef clause);
+    bool isReason(ClauseRef clause);
+    void reduceLearnedClauses();
+    void collectGarbage();
+    void relocateClause(ClauseRef clause, vector<Lit>& new_arena);
+    void specializeFixedWidthClauses();
+    void eliminateClauses();
+    int clauseSize(ClauseRef clause);
+    Lit* clauseLiterals(ClauseRef clause);
+    bool isBudgetExhausted();
+    double estimateMemoryMB();
+
+public: 
+    void reset();
+    void load(const CNFFormula& input);
+    ReturnValue search();
+    int numVariables();
+    bool modelValue(int variable);
+    void suggestPhase(int variable, bool is_negative);
+    void suggestAssignment(const vector<Lit>& literals);
+    void setBudget(const SolverBudget& new_budget);
+    void setOptions(const SolverOptions& new_options);
+    void setSeed(uint64_t seed);
+    void interrupt();
+    const SolverStatistics& getStatistics();
+};
+
+// Note: takes in a packed literal
+// updates literal_values for both polarities of its variable
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::assignLiteral(Lit literal_to_make_true, int decision_level, int triggering_clause) {
+    int variable = literalVariable(literal_to_make_true);
+    literal_values[literal_to_make_true] = LIT_TRUE;
+    literal_values[negateLiteral(literal_to_make_true)] = LIT_FALSE;
+    variable_assignment_decision_level[variable] = decision_level;
+    variable_assignment_triggering_clause[variable] = triggering_clause;
+    branching.onAssign(variable);
+    trail.push_back(literal_to_make_true);
+    num_assigned++;
+    if (triggering_clause != -1) statistics.propagations++;
+}
+
+// Note: takes in a 0-indexed variable
+// resets literal_values for both polarities of the variable
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::unassignVariable(int variable_to_unassign) {
+    if (save_phases) phases.onUnassign(variable_to_unassign, literal_values[makeLiteral(variable_to_unassign, true)] == LIT_TRUE);
+    literal_values[makeLiteral(variable_to_unassign, false)] = LIT_UNASSIGNED;
+    literal_values[makeLiteral(variable_to_unassign, true)] = LIT_UNASSIGNED;
+    variable_assignment_decision_level[variable_to_unassign] = -1;
+    variable_assignment_triggering_clause[variable_to_unassign] = -1;
+    branching.onUnassign(variable_to_unassign);
+    num_assigned--;
+}
+
+/* unassign every variable assigned above the given level.
+ * Literals of lower levels found past the level's trail start (only possible
+ * with chronological backtracking) are kept in order and propagated again.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::backtrack(int decision_level_to_backtrack) {
+    if (trail_level_start.size() <= decision_level_to_backtrack) return;
+    int new_trail_size = trail_level_start[decision_level_to_backtrack];
+    int kept = new_trail_size;
+    for (int i = new_trail_size; i < trail.size(); i++) {
+        int variable = literalVariable(trail[i]);
+        if (variable_assignment_decision_level[variable] > decision_level_to_backtrack) {
+            unassignVariable(variable);
+        } else {
+            trail[kept++] = trail[i];
+        }
+    }
+    trail.resize(kept);
+    trail_level_start.resize(decision_level_to_backtrack);
+    propagation_head = new_trail_size;
+}
+
+// returns the position (>= 2) of a literal in literals[2..size) that is not false, or 0 if there is none
+inline int findReplacementWatch(const Lit* literals, int size, const signed char* literal_values) {
+    for (int k = 2; k < size; k++) {
+        if (literal_values[literals[k]] != LIT_FALSE) return k;
+    }
+    return 0;
+}
+
+// same search with the width known at compile time, so the loop is fully unrolled
+template <int Width>
+inline int findReplacementWatch(const Lit* literals, const signed char* literal_values) {
+    for (int k = 2; k < Width; k++) {
+        if (literal_values[literals[k]] != LIT_FALSE) return k;
+    }
+    return 0;
+}
+
+template <class Branching, class Restart, class Phase>
+int CDCLSolver<Branching, Restart, Phase>::clauseSize(ClauseRef clause) {
+    return (clause < fixed_clause_end) ? fixed_clause_width : clause_arena[clause];
+}
+
+template <class Branching, class Restart, class Phase>
+Lit* CDCLSolver<Branching, Restart, Phase>::clauseLiterals(ClauseRef clause) {
+    return &clause_arena[(clause < fixed_clause_end) ? clause : clause + 1];
+}
+
+// packed clauses have no header and read as unmarked input clauses
+template <class Branching, class Restart, class Phase>
+Lit CDCLSolver<Branching, Restart, Phase>::clauseHeader(ClauseRef clause) {
+    return (clause < fixed_clause_end) ? (Lit) fixed_clause_width : clause_arena[clause - 1];
+}
+
+// picks the propagation kernel matching the packed input clauses
+template <class Branching, class Restart, class Phase>
+ReturnValue CDCLSolver<Branching, Restart, Phase>::UnitPropagation(int decision_level) {
+    switch (fixed_clause_width) {
+        case 3: return propagateWatches<3>(decision_level);
+        case 4: return propagateWatches<4>(decision_level);
+        case 5: return propagateWatches<5>(decision_level);
+        default: return propagateWatches<0>(decision_level);
+    }
+}
+
+/* two-watched-literal propagation of everything on the trail that has not been propagated yet.
+ * FixedWidth is the width of the packed input clauses (0 when they are not packed);
+ * those clauses take the unrolled path, learned clauses the generic one.
+*/
+template <class Branching, class Restart, class Phase>
+template <int FixedWidth>
+ReturnValue CDCLSolver<Branching, Restart, Phase>::propagateWatches(int decision_level) {
+    while (propagation_head < trail.size()) {
+        // the negation of each newly assigned literal has just become false
+        Lit false_literal = negateLiteral(trail[propagation_head++]);
+        vector<Watcher>& watch_list = watches[false_literal];
+        propagation_ticks += 1 + watch_list.size();
+        Watcher* i = watch_list.data();
+        Watcher* j = i;
+        Watcher* end = i + watch_list.size();
+
+        while (i != end) {
+            Watcher watcher = *i++;
+
+            // clause already satisfied by its blocker: no need to look at the clause
+            if (literal_values[watcher.blocker] == LIT_TRUE) {
+                *j++ = watcher;
+                continue;
+            }
+
+            if (watcher.clause == BINARY_CLAUSE) {
+                // binary clause: the blocker is the only other literal
+                *j++ = watcher;
+                if (literal_values[watcher.blocker] == LIT_FALSE) {
+                    conflict_clause_number = BINARY_REASON;
+                    conflict_binary_clause[0] = false_literal;
+                    conflict_binary_clause[1] = watcher.blocker;
+                    while (i != end) *j++ = *i++;
+                    watch_list.resize(j - watch_list.data());
+                    return ReturnValue::unsat;
+                }
+                // with chronological backtracking the implication takes the level of its reason
+                int implied_level = (options.chrono_backtrack_threshold < 0) ? decision_level
+                    : variable_assignment_decision_level[literalVariable(false_literal)];
+                assignLiteral(watcher.blocker, implied_level, BINARY_REASON);
+                variable_binary_reason[literalVariable(watcher.blocker)] = false_literal;
+                continue;
+            }
+
+            // start loading the next clause while this one is processed
+            if (i != end && i->clause != BINARY_CLAUSE) PREFETCH_CLAUSE(&clause_arena[i->clause]);
+
+            bool is_fixed_width = FixedWidth > 0 && watcher.clause < fixed_clause_end;
+            Lit* literals = &clause_arena[is_fixed_width ? watcher.clause : watcher.clause + 1];
+            // make sure the false literal is literals[1]
+            if (literals[0] == false_literal) {
+                literals[0] = literals[1];
+                literals[1] = false_literal;
+            }
+            // if the other watched literal is true the clause is satisfied
+            Lit first = literals[0];
+            Watcher updated_watcher = {watcher.clause, first};
+            if (first != watcher.blocker && literal_values[first] == LIT_TRUE) {
+                *j++ = updated_watcher;
+                continue;
+            }
+
+            // look for a literal that is not false to watch instead
+            int new_watch = is_fixed_width
+                ? findReplacementWatch<FixedWidth>(literals, literal_values.data())
+                : findReplacementWatch(literals, clause_arena[watcher.clause], literal_values.data());
+            if (new_watch != 0) {
+                literals[1] = literals[new_watch];
+                literals[new_watch] = false_literal;
+                watches[literals[1]].push_back(updated_watcher);
+                continue;
+            }
+
+            // no replacement: clause is unit on its first literal, or unsat
+            if (literal_values[first] == LIT_FALSE) {
+                *j++ = updated_watcher;
+                conflict_clause_number = watcher.clause;
+                while (i != end) *j++ = *i++;
+                watch_list.resize(j - watch_list.data());
+                return ReturnValue::unsat;
+            }
+            if (options.chrono_backtrack_threshold >= 0) {
+                /* the implication takes the highest level among the false literals, and that
+                 * literal becomes the second watch, so both watches are unassigned together
+                */
+                int size = is_fixed_width ? FixedWidth : clause_arena[watcher.clause];
+                int highest = 1;
+                int implied_level = variable_assignment_decision_level[literalVariable(false_literal)];
+                for (int k = 2; k < size; k++) {
+                    int level = variable_assignment_decision_level[literalVariable(literals[k])];
+                    if (level > implied_level) {
+                        implied_level = level;
+                        highest = k;
+                    }
+                }
+                if (highest != 1) {
+                    literals[1] = literals[highest];
+                    literals[highest] = false_literal;
+                    watches[literals[1]].push_back(updated_watcher);
+                } else {
+                    *j++ = updated_watcher;
+                }
+                assignLiteral(first, implied_level, watcher.clause);
+                continue;
+            }
+            *j++ = updated_watcher;
+            assignLiteral(first, decision_level, watcher.clause);
+        }
+        watch_list.resize(j - watch_list.data());
+    }
+    // reset conflict clause to null if unit propagation succeeds
+    conflict_clause_number = -1;
+    return ReturnValue::normal;
+}
+
+// returns a packed literal to be assigned true
+// the variable comes from the branching policy, its polarity from the phase policy
+template <class Branching, class Restart, class Phase>
+Lit CDCLSolver<Branching, Restart, Phase>::pickBranchingVariable() {
+    int variable = branching.pickVariable(literal_values, num_variables - num_assigned);
+    return makeLiteral(variable, phases.pickNegative(variable, literal_polarity_difference));
+}
+
+/* the next hint that is still unassigned; hints propagation already made true
+ * are skipped, and so are those it made false, whose phases say the same
+*/
+template <class Branching, class Restart, class Phase>
+Lit CDCLSolver<Branching, Restart, Phase>::pickHintedLiteral() {
+    while (next_hint < hint_literals.size()) {
+        Lit literal = hint_literals[next_hint++];
+        if (literal_values[literal] == LIT_UNASSIGNED) return literal;
+    }
+    return pickBranchingVariable();
+}
+
+// remove the watcher of a clause from one literal's watch list
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::removeWatch(Lit literal, ClauseRef clause) {
+    vector<Watcher>& watch_list = watches[literal];
+    for (int i = 0; i < watch_list.size(); i++) {
+        if (watch_list[i].clause == clause) {
+            watch_list[i] = watch_list.back();
+            watch_list.pop_back();
+            break;
+        }
+    }
+}
+
+// stop watching one literal of a clause and watch another literal instead
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::moveWatch(ClauseRef clause, Lit from, Lit to, Lit blocker) {
+    removeWatch(from, clause);
+    watches[to].push_back({clause, blocker});
+}
+
+/* highest level among the literals of the conflict clause, and how many literals
+ * are assigned at it. forced_literal is one of them. A long conflict clause has
+ * its two highest-level literals moved into the watched slots.
+*/
+template <class Branching, class Restart, class Phase>
+int CDCLSolver<Branching, Restart, Phase>::findConflictLevel(Lit& forced_literal, int& num_literals_at_conflict_level) {
+    Lit* literals = conflict_binary_clause;
+    int size = 2;
+    if (conflict_clause_number != BINARY_REASON) {
+        literals = clauseLiterals(conflict_clause_number);
+        size = clauseSize(conflict_clause_number);
+    }
+    Lit old_watches[2] = {literals[0], literals[1]};
+    for (int position = 0; position < 2; position++) {
+        int best = position;
+        for (int k = position + 1; k < size; k++) {
+            if (variable_assignment_decision_level[literalVariable(literals[k])]
+                > variable_assignment_decision_level[literalVariable(literals[best])]) best = k;
+        }
+        swap(literals[position], literals[best]);
+    }
+    if (conflict_clause_number != BINARY_REASON) {
+        // pair each literal that stopped being watched with one that started
+        Lit removed[2], added[2];
+        int num_removed = 0, num_added = 0;
+        for (int position = 0; position < 2; position++) {
+            if (old_watches[position] != literals[0] && old_watches[position] != literals[1]) removed[num_removed++] = old_watches[position];
+            if (literals[position] != old_watches[0] && literals[position] != old_watches[1]) added[num_added++] = literals[position];
+        }
+        for (int i = 0; i < num_removed; i++) {
+            moveWatch(conflict_clause_number, removed[i], added[i], (added[i] == literals[0]) ? literals[1] : literals[0]);
+        }
+    }
+
+    int conflict_level = variable_assignment_decision_level[literalVariable(literals[0])];
+    num_literals_at_conflict_level = 0;
+    for (int k = 0; k < size; k++) {
+        if (variable_assignment_decision_level[literalVariable(literals[k])] == conflict_level) num_literals_at_conflict_level++;
+    }
+    forced_literal = literals[0];
+    return conflict_level;
+}
+
+/* returns the level search continues at, or -1 if the conflict only involves
+ * level 0 literals (possible with chronological backtracking), i.e. the formula is unsat
+*/
+template <class Branching, class Restart, class Phase>
+int CDCLSolver<Branching, Restart, Phase>::learnConflictAndBacktrack(int decision_level){
+    if (options.chrono_backtrack_threshold >= 0) {
+        // the conflict may lie entirely below the current level on an out-of-order trail
+        Lit forced_literal;
+        int num_literals_at_conflict_level;
+        int conflict_level = findConflictLevel(forced_literal, num_literals_at_conflict_level);
+        if (conflict_level == 0) return -1;
+        if (num_literals_at_conflict_level == 1) {
+            // missed implication: the clause was unit one level lower, nothing to learn
+            backtrack(conflict_level - 1);
+            if (conflict_clause_number == BINARY_REASON) {
+                Lit other = conflict_binary_clause[1];
+                assignLiteral(forced_literal, variable_assignment_decision_level[literalVariable(other)], BINARY_REASON);
+                variable_binary_reason[literalVariable(forced_literal)] = other;
+            } else {
+                Lit second = clauseLiterals(conflict_clause_number)[1];
+                assignLiteral(forced_literal, variable_assignment_decision_level[literalVariable(second)], conflict_clause_number);
+            }
+            return conflict_level - 1;
+        }
+        backtrack(conflict_level);
+        decision_level = conflict_level;
+    }
+
+    // slot 0 is reserved for the negation of the cut point found below
+    vector<Lit> clause_to_learn(1);
+    int num_literals_assigned_this_level = 0;
+    int trail_index = trail.size() - 1;
+    // to be used for resolution
+    int resolution_variable = -1;
+    Lit resolution_literal = 0;
+
+    // start from the conflicting clause
+    int reason = conflict_clause_number;
+    Lit binary_reason[2] = {conflict_binary_clause[0], conflict_binary_clause[1]};
+    // LRAT: ids of the clauses resolved, conflict first, and the level 0 variables met
+    vector<uint64_t> resolved_ids;
+    vector<int> root_variables;
+    if (is_tracking_ids) {
+        resolved_ids.push_back((reason == BINARY_REASON) ? binary_clause_ids[binaryClauseKey(binary_reason[0], binary_reason[1])]
+            : clause_ids[reason]);
+    }
+
+    while (true) {
+        const Lit* reason_literals = binary_reason;
+        int reason_size = 2;
+        if (reason != BINARY_REASON) {
+            reason_literals = clauseLiterals(reason);
+            reason_size = clauseSize(reason);
+            if (reason >= fixed_clause_end) clause_arena[reason - 1] |= CLAUSE_USED;
+        }
+        // resolve the current clause with this reason: literals from this level are counted,
+        // earlier levels go straight into the learned clause, level 0 literals are always false
+        for (int i = 0; i < reason_size; i++) {
+            int variable = literalVariable(reason_literals[i]);
+            if (variable == resolution_variable || seen[variable]) continue;
+            if (variable_assignment_decision_level[variable] == 0) {
+                if (is_tracking_ids) root_variables.push_back(variable);
+                continue;
+            }
+            seen[variable] = 1;
+            branching.onConflictVariable(variable);
+            if (variable_assignment_decision_level[variable] == decision_level) {
+                num_literals_assigned_this_level++;
+            } else {
+                clause_to_learn.push_back(reason_literals[i]);
+            }
+        }
+        // walk back the trail to the latest variable of this level still in the clause
+        while (!seen[literalVariable(trail[trail_index])]
+            || variable_assignment_decision_level[literalVariable(trail[trail_index])] != decision_level) trail_index--;
+        resolution_literal = trail[trail_index];
+        trail_index--;
+        resolution_variable = literalVariable(resolution_literal);
+        seen[resolution_variable] = 0;
+        num_literals_assigned_this_level--;
+
+        // if there is only 1 literal in the clause assigned this level,
+        // it is a cut point of the implication graph. i.e. ready to learn
+        if (num_literals_assigned_this_level == 0) break;
+
+        // otherwise continue resolving with the clause that forced it
+        reason = variable_assignment_triggering_clause[resolution_variable];
+        if (reason == BINARY_REASON) {
+            binary_reason[0] = resolution_literal;
+            binary_reason[1] = variable_binary_reason[resolution_variable];
+        }
+        if (is_tracking_ids) resolved_ids.push_back(reasonClauseId(resolution_variable));
+    }
+    clause_to_learn[0] = negateLiteral(resolution_literal);
+    for (int i = 1; i < clause_to_learn.size(); i++) {
+        seen[literalVariable(clause_to_learn[i])] = 0;
+    }
+
+    // update states
+    statistics.learned_clauses++;
+    num_formula_literals += clause_to_learn.size();
+    for (int i = 0; i < clause_to_learn.size(); i++)  {
+        int variable = literalVariable(clause_to_learn[i]);
+        if (isNegativeLiteral(clause_to_learn[i])) {
+            literal_polarity_difference[variable]--;
+        } else {
+            literal_polarity_difference[variable]++;
+        }
+    }
+    branching.onLearnedClause(clause_to_learn, literal_values);
+    // literal block distance: number of distinct decision levels in the clause
+    current_level_stamp++;
+    int lbd = 0;
+    for (int i = 0; i < clause_to_learn.size(); i++) {
+        int level = variable_assignment_decision_level[literalVariable(clause_to_learn[i])];
+        if (level_stamp[level] != current_level_stamp) {
+            level_stamp[level] = current_level_stamp;
+            lbd++;
+        }
+    }
+    restarts.onLearnedClause(lbd);
+    // update current number of clauses
+    num_clauses++;
+    
+    // determining backtracking decision level
+    // find max level where literal in learnt clause has been assigned that is not current level,
+    // and move that literal to slot 1 so it gets watched
+    int assertion_level = 0;
+    for (int i = 1; i < clause_to_learn.size(); i++) {
+        int possible_decision_level = variable_assignment_decision_level[literalVariable(clause_to_learn[i])];
+        if (possible_decision_level > assertion_level) {
+            assertion_level = possible_decision_level;
+            swap(clause_to_learn[1], clause_to_learn[i]);
+        }
+    }
+    // a long backjump would throw away assignments that are likely re-derived:
+    // go back one level instead and put the asserted literal on the trail out of order
+    int decision_level_to_backtrack = assertion_level;
+    if (options.chrono_backtrack_threshold >= 0 && decision_level - assertion_level > options.chrono_backtrack_threshold) {
+        decision_level_to_backtrack = decision_level - 1;
+    }
+    // unassign all variables post-backtracking level
+    backtrack(decision_level_to_backtrack);
+
+    // the learned clause follows by unit propagation from the level 0 units and the
+    // resolved clauses, taken in trail order
+    uint64_t learned_id = 0;
+    if (proof.isOpen()) {
+        if (is_tracking_ids) {
+            proof_hints.clear();
+            sort(root_variables.begin(), root_variables.end());
+            root_variables.erase(unique(root_variables.begin(), root_variables.end()), root_variables.end());
+            for (int i = 0; i < root_variables.size(); i++) proof_hints.push_back(unitClauseId(root_variables[i]));
+            proof_hints.insert(proof_hints.end(), resolved_ids.rbegin(), resolved_ids.rend());
+        }
+        learned_id = logAddedClause(clause_to_learn.data(), clause_to_learn.size());
+    }
+
+    // learn clause; it is now unit on clause_to_learn[0]
+    if (clause_to_learn.size() == 1) {
+        assignLiteral(clause_to_learn[0], 0, -1);
+        if (is_tracking_ids) unit_clause_ids[literalVariable(clause_to_learn[0])] = learned_id;
+    } else if (clause_to_learn.size() == 2) {
+        addBinaryClause(clause_to_learn[0], clause_to_learn[1], learned_id);
+        assignLiteral(clause_to_learn[0], assertion_level, BINARY_REASON);
+        variable_binary_reason[literalVariable(clause_to_learn[0])] = clause_to_learn[1];
+    } else {
+        ClauseRef learned_clause = allocateClause(clause_to_learn, true, lbd, learned_id);
+        assignLiteral(clause_to_learn[0], assertion_level, learned_clause);
+    }
+    return decision_level_to_backtrack;
+}
+
+// binary clauses live only in the watch lists of their two literals
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::addBinaryClause(Lit first, Lit second, uint64_t id) {
+    if (is_tracking_ids) {
+        // a duplicate would leave two clauses under one key; the first is enough
+        if (!binary_clause_ids.emplace(binaryClauseKey(first, second), id).second) return;
+    }
+    watches[first].push_back({BINARY_CLAUSE, second});
+    watches[second].push_back({BINARY_CLAUSE, first});
+}
+
+// copy a clause of 3 or more literals into clause_arena, add it to formula and watch its first two literals
+template <class Branching, class Restart, class Phase>
+ClauseRef CDCLSolver<Branching, Restart, Phase>::allocateClause(const vector<Lit>& clause, bool learned, int lbd, uint64_t id) {
+    clause_arena.push_back((learned ? CLAUSE_LEARNED : 0) | min((Lit) lbd, CLAUSE_LBD_MASK));
+    ClauseRef clause_ref = clause_arena.size();
+    clause_arena.push_back(clause.size());
+    clause_arena.insert(clause_arena.end(), clause.begin(), clause.end());
+    formula.push_back(clause_ref);
+    if (is_tracking_ids) {
+        clause_ids.resize(clause_arena.size());
+        clause_ids[clause_ref] = id;
+    }
+    watches[clause[0]].push_back({clause_ref, clause[1]});
+    watches[clause[1]].push_back({clause_ref, clause[0]});
+    return clause_ref;
+}
+
+/* if all input clauses of 3+ literals have the same width, repack them without
+ * size words so propagation can use the kernel specialized for that width.
+ * Must run before any clause is learned.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::specializeFixedWidthClauses() {
+    fixed_clause_width = 0;
+    fixed_clause_end = 0;
+    if (formula.empty()) return;
+    int width = clause_arena[formula[0]];
+    if (width < 3 || width > 5) return;
+    for (int i = 0; i < formula.size(); i++) {
+        if (clause_arena[formula[i]] != width) return;
+    }
+
+    // clause i moves from offset i * (width + 2) + 1 to i * width
+    vector<Lit>& packed_clauses = spare_arena;
+    packed_clauses.clear();
+    packed_clauses.reserve(formula.size() * width);
+    vector<uint64_t> packed_ids;
+    if (is_tracking_ids) packed_ids.resize(formula.size() * width);
+    for (int i = 0; i < formula.size(); i++) {
+        packed_clauses.insert(packed_clauses.end(), &clause_arena[formula[i] + 1], &clause_arena[formula[i] + 1] + width);
+        if (is_tracking_ids) packed_ids[i * width] = clause_ids[formula[i]];
+        formula[i] = i * width;
+    }
+    clause_arena.swap(packed_clauses);
+    if (is_tracking_ids) clause_ids.swap(packed_ids);
+    for (int i = 0; i < watches.size(); i++) {
+        for (int j = 0; j < watches[i].size(); j++) {
+            if (watches[i][j].clause != BINARY_CLAUSE) {
+                watches[i][j].clause = watches[i][j].clause / (width + 2) * width;
+            }
+        }
+    }
+    fixed_clause_width = width;
+    fixed_clause_end = clause_arena.size();
+}
+
+// add a clause of the input, dropping repeated literals and tautologies
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::addClause(vector<Lit>& clause, uint64_t id) {
+    sort(clause.begin(), clause.end());
+    clause.erase(unique(clause.begin(), clause.end()), clause.end());
+    // x and -x of a variable are adjacent after sorting
+    for (int i = 0; i + 1 < clause.size(); i++) {
+        if (clause[i + 1] == negateLiteral(clause[i])) return;
+    }
+    if (clause.size() == 0) {
+        has_empty_clause = true;
+        empty_clause_id = id;
+    } else if (clause.size() == 1) {
+        unit_clauses.push_back(clause[0]);
+        if (is_tracking_ids) input_unit_ids.push_back(id);
+    } else if (clause.size() == 2) {
+        addBinaryClause(clause[0], clause[1], id);
+    } else {
+        allocateClause(clause, false, clause.size(), id);
+    }
+}
+
+/* blocked (and covered) clause elimination on the clauses as loaded: they are
+ * collected from the arena and the watch lists, reduced, and loaded back.
+ * Must run before search assigns or learns anything.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::eliminateClauses() {
+    CNFFormula clauses;
+    clauses.num_variables = num_variables;
+    vector<Lit> clause;
+    // LRAT ids of the collected clauses
+    vector<uint64_t> ids;
+    for (int i = 0; i < unit_clauses.size(); i++) {
+        clause.assign(1, unit_clauses[i]);
+        clauses.addClause(clause);
+        if (is_tracking_ids) ids.push_back(input_unit_ids[i]);
+    }
+    for (Lit literal = 0; literal < watches.size(); literal++) {
+        for (int i = 0; i < watches[literal].size(); i++) {
+            // each binary clause is listed under both its literals
+            const Watcher& watcher = watches[literal][i];
+            if (watcher.clause != BINARY_CLAUSE || watcher.blocker < literal) continue;
+            clause.assign(1, literal);
+            clause.push_back(watcher.blocker);
+            clauses.addClause(clause);
+            if (is_tracking_ids) ids.push_back(binary_clause_ids[binaryClauseKey(literal, watcher.blocker)]);
+        }
+    }
+    for (int i = 0; i < formula.size(); i++) {
+        const Lit* literals = clauseLiterals(formula[i]);
+        clause.assign(literals, literals + clauseSize(formula[i]));
+        clauses.addClause(clause);
+        if (is_tracking_ids) ids.push_back(clause_ids[formula[i]]);
+    }
+    CNFFormula original_clauses;
+    if (proof.isOpen()) original_clauses = clauses;
+
+    int num_blocked_before = clause_eliminator.num_blocked + clause_eliminator.num_covered;
+    clause_eliminator.eliminate(clauses, options.covered_clause_elimination);
+    statistics.eliminated_clauses += clause_eliminator.num_blocked + clause_eliminator.num_covered - num_blocked_before;
+
+    // removing clauses needs no justification in a proof of unsatisfiability
+    vector<uint64_t> kept_ids;
+    for (int i = 0; i < original_clauses.numClauses(); i++) {
+        if (!clause_eliminator.isRemoved(i)) {
+            if (is_tracking_ids) kept_ids.push_back(ids[i]);
+        } else if (is_tracking_ids) {
+            proof.deleteClause(ids[i]);
+        } else {
+            proof.deleteClause(original_clauses.clauseLiterals(i), original_clauses.clauseSize(i));
+        }
+    }
+
+    clause_arena.clear();
+    formula.clear();
+    unit_clauses.clear();
+    input_unit_ids.clear();
+    clause_ids.clear();
+    binary_clause_ids.clear();
+    for (int i = 0; i < watches.size(); i++) watches[i].clear();
+    fixed_clause_width = 0;
+    fixed_clause_end = 0;
+    num_clauses = clauses.numClauses();
+    num_formula_literals = clauses.literals.size();
+    for (int i = 0; i < num_clauses; i++) {
+        clause.assign(clauses.clauseLiterals(i), clauses.clauseLiterals(i) + clauses.clauseSize(i));
+        addClause(clause, is_tracking_ids ? kept_ids[i] : 0);
+    }
+    specializeFixedWidthClauses();
+}
+
+template <class Branching, class Restart, class Phase>
+ReturnValue CDCLSolver<Branching, Restart, Phase>::runCDCL() {
+    int decision_level = 0;
+    // search starts focused; options may have changed since load()
+    stable_mode = false;
+    num_mode_switches = 0;
+    propagation_ticks = 0;
+    first_mode_ticks = 0;
+    next_mode_switch = options.mode_switch_conflicts;
+    next_hint = 0;
+    next_vivification = options.vivify_interval;
+    last_vivification_ticks = 0;
+    next_reduction = options.reduce_interval;
+    num_reductions = 0;
+
+    // -------------------------
+    // Edge case checking / short circuiting:
+    // -------------------------
+
+    // check if initialized formula has no clauses: return sat
+    if (num_clauses == 0) return ReturnValue::sat;
+    // if initialized formula has empty clauses: return unsat
+    if (has_empty_clause) {
+        if (proof.isOpen()) logEmptyClause(nullptr, 0, empty_clause_id);
+        return ReturnValue::unsat;
+    }
+    // assert unit clauses of the input
+    for (int i = 0; i < unit_clauses.size(); i++) {
+        if (literal_values[unit_clauses[i]] == LIT_FALSE) {
+            if (proof.isOpen()) logEmptyClause(&unit_clauses[i], 1, is_tracking_ids ? input_unit_ids[i] : 0);
+            return ReturnValue::unsat;
+        }
+        if (literal_values[unit_clauses[i]] == LIT_UNASSIGNED) {
+            assignLiteral(unit_clauses[i], 0, -1);
+            if (is_tracking_ids) unit_clause_ids[literalVariable(unit_clauses[i])] = input_unit_ids[i];
+        }
+    }
+    // Unit propagation
+    ReturnValue up_result = UnitPropagation(decision_level);
+    if (up_result == ReturnValue::unsat) return refuteFromConflict();
+
+    // -------------------------
+    // Now entering CDCL Main Loop
+    // -------------------------
+    
+    // while not all variables are assigned: 
+    while (num_assigned != num_variables) {
+        // cout << "num_assigned: " << num_assigned << " num_variables: " << num_variables << endl;
+        // pick a variable to assign
+        // stop cleanly with UNKNOWN if any budget ran out or we were interrupted
+        if (isBudgetExhausted()) return ReturnValue::unknown;
+        if (checkpoint_writer.isOpen() && statistics.conflicts >= next_checkpoint_check) {
+            next_checkpoint_check = statistics.conflicts + CHECKPOINT_CHECK_CONFLICTS;
+            if (chrono::steady_clock::now() >= next_checkpoint_time) writeCheckpoint(false);
+        }
+
+        Lit literal_to_make_true = (next_hint < hint_literals.size()) ? pickHintedLiteral() : pickBranchingVariable();
+        statistics.decisions++;
+        decision_level++;
+        trail_level_start.push_back(trail.size());
+        assignLiteral(literal_to_make_true, decision_level, -1);
+
+        // unit propagate | generate implication graph to check for unsat
+        up_result = UnitPropagation(decision_level);
+
+        while (up_result == ReturnValue::unsat) {
+            // Shortcircuit: If at any moment after learning some clauses and jumping back to 
+            // decision lvl 0 we realize through unit propagation the formula is unsat,
+            // return unsat
+            if (decision_level == 0) return refuteFromConflict();
+            statistics.conflicts++;
+            // the hints led here: from now on they only live on in the phases
+            next_hint = hint_literals.size();
+            if (isBudgetExhausted()) return ReturnValue::unknown;
+            // everything below the current level was conflict free
+            phases.onConflict(trail, trail_level_start.back());
+            
+            // otherwise learn new clause then backtrack
+            decision_level = learnConflictAndBacktrack(decision_level);
+            if (decision_level < 0) return refuteFromConflict();
+
+            // unit propagate for again
+            up_result = UnitPropagation(decision_level);
+
+            // cout << "backtracked_decision_level: " << decision_level << endl;
+        }
+
+        if (options.reduce_interval >= 0 && statistics.conflicts >= next_reduction) {
+            reduceLearnedClauses();
+            num_reductions++;
+            next_reduction = statistics.conflicts + options.reduce_interval + num_reductions * REDUCE_INTERVAL_INCREMENT;
+        }
+
+        // restart when the policy asks for it, or into the other mode
+        if (isModeSwitchDue()) {
+            switchMode();
+            backtrack(0);
+            decision_level = 0;
+            branching.onRestart();
+        } else if (restarts.shouldRestart(statistics.conflicts)) {
+            backtrack(0);
+            decision_level = 0;
+            branching.onRestart();
+        }
+        // vivification works at level 0, so it only runs right after a restart
+        if (decision_level == 0 && options.vivify_interval >= 0 && statistics.conflicts >= next_vivification) {
+            if (!vivifyClauses()) return ReturnValue::unsat;
+            next_vivification = statistics.conflicts + options.vivify_interval;
+        }
+
+        // if unit propagation finishes without discovering UNSAT, continue to pick next variable
+    }
+    // after all variables have been assigned, return SAT
+    return ReturnValue::sat;
+}
+
+/* forgets the loaded formula, its learned clauses and all search state, but keeps
+ * the memory: the arena, the watch lists, the per-variable tables and the
+ * policies' heaps only ever grow, so a solver reused across instances stops
+ * allocating once it has seen the largest of them.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::reset() {
+    num_variables = 0;
+    num_clauses = 0;
+    conflict_clause_number = -1;
+    num_assigned = 0;
+    num_formula_literals = 0;
+    propagation_head = 0;
+    save_phases = true;
+    has_empty_clause = false;
+    is_preprocessed = false;
+    clause_eliminator.clear();
+    fixed_clause_width = 0;
+    fixed_clause_end = 0;
+
+    is_tracking_ids = false;
+    next_clause_id = 1;
+    empty_clause_id = 0;
+    clause_ids.clear();
+    binary_clause_ids.clear();
+    input_unit_ids.clear();
+    unit_clause_ids.clear();
+    formula_hash = 0;
+    has_tried_resume = false;
+    resumed_conflicts = 0;
+    hint_literals.clear();
+
+    clause_arena.clear();
+    formula.clear();
+    unit_clauses.clear();
+    // clearing each list instead of the outer vector keeps their capacity
+    for (int i = 0; i < watches.size(); i++) watches[i].clear();
+    trail.clear();
+    trail_level_start.clear();
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::load(const CNFFormula& input) {
+    reset();
+    num_variables = input.num_variables;
+    num_clauses = input.numClauses();
+
+    // LRAT needs the ids of the input clauses, so the choice is made here
+    is_tracking_ids = options.proof_lrat && !options.proof_path.empty();
+    next_clause_id = num_clauses + 1;
+    unit_clause_ids.assign(is_tracking_ids ? num_variables : 0, 0);
+    // snapshots name the formula they were taken on
+    if (!options.checkpoint_path.empty() || !options.resume_path.empty()) formula_hash = formulaHash(input);
+
+    // size the per-variable tables; assign() reuses their capacity
+    watches.resize(2 * num_variables);
+    seen.assign(num_variables, 0);
+    variable_binary_reason.assign(num_variables, 0);
+    literal_values.assign(2 * num_variables, LIT_UNASSIGNED);
+    variable_assignment_decision_level.assign(num_variables, -1);
+    variable_assignment_triggering_clause.assign(num_variables, -1);
+    variable_occurrences.assign(num_variables, 0);
+    literal_polarity_difference.assign(num_variables, 0);
+
+    vector<Lit>& clause = input_clause;
+    for (int i = 0; i < num_clauses; i++) {
+        const Lit* literals = input.clauseLiterals(i);
+        clause.assign(literals, literals + input.clauseSize(i));
+        for (int j = 0; j < clause.size(); j++) {
+            int variable = literalVariable(clause[j]);
+            variable_occurrences[variable]++;
+            if (isNegativeLiteral(clause[j])) {
+                literal_polarity_difference[variable]--;
+            } else {
+                literal_polarity_difference[variable]++;
+            }
+        }
+        num_formula_literals += clause.size();
+        addClause(clause, i + 1);
+    }
+    // random k-SAT inputs are uniform width; switch them to the packed layout
+    specializeFixedWidthClauses();
+    // hand the input statistics to the policies
+    branching.init(variable_occurrences, random_seed);
+    restarts.init();
+    phases.init(num_variables);
+
+    level_stamp.assign(num_variables + 1, 0);
+    current_level_stamp = 0;
+}
+
+template <class Branching, class Restart, class Phase>
+bool CDCLSolver<Branching, Restart, Phase>::isModeSwitchDue() {
+    if (!(Branching::has_modes || Restart::has_modes || Phase::has_modes)) return false;
+    if (options.mode_switch_conflicts < 0) return false;
+    // the first focused mode is always measured in conflicts
+    if (num_mode_switches == 0 || !options.mode_switch_by_ticks) return statistics.conflicts >= next_mode_switch;
+    return propagation_ticks >= next_mode_switch;
+}
+
+/* focused -> stable -> focused ... Modes get longer as search goes on: every
+ * focused/stable pair lasts twice as long as the one before.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::switchMode() {
+    if (num_mode_switches == 0) first_mode_ticks = propagation_ticks;
+    num_mode_switches++;
+    stable_mode = !stable_mode;
+    long long length_factor = 1LL << min(num_mode_switches / 2, 30);
+    if (options.mode_switch_by_ticks) {
+        next_mode_switch = propagation_ticks + first_mode_ticks * length_factor;
+    } else {
+        next_mode_switch = statistics.conflicts + options.mode_switch_conflicts * length_factor;
+    }
+    branching.setStableMode(stable_mode);
+    restarts.setStableMode(stable_mode);
+    phases.setStableMode(stable_mode);
+}
+
+/* assigns the negation of the clause's literals one at a time (each at a new level)
+ * and propagates, with the clause itself detached. vivified receives the literals
+ * the clause can be shortened to: the ones assigned before propagation conflicts,
+ * plus the first literal propagation makes true. Literals propagation makes false
+ * are left out. is_satisfied is set if a literal is true at level 0.
+ * Leaves the solver at level 0.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::vivifyLiterals(ClauseRef clause, vector<Lit>& vivified, bool& is_satisfied) {
+    const Lit* literals = clauseLiterals(clause);
+    int size = clauseSize(clause);
+    vivified.clear();
+    is_satisfied = false;
+    for (int k = 0; k < size; k++) {
+        if (literal_values[literals[k]] == LIT_TRUE && variable_assignment_decision_level[literalVariable(literals[k])] == 0) {
+            is_satisfied = true;
+            return;
+        }
+    }
+    int decision_level = 0;
+    bool is_conflict = false;
+    bool is_implied = false;
+    for (int k = 0; k < size; k++) {
+        Lit literal = literals[k];
+        if (literal_values[literal] == LIT_FALSE) continue;
+        vivified.push_back(literal);
+        // implied by the negation of the literals before it
+        if (literal_values[literal] == LIT_TRUE) {
+            is_implied = true;
+            break;
+        }
+        decision_level++;
+        trail_level_start.push_back(trail.size());
+        assignLiteral(negateLiteral(literal), decision_level, -1);
+        if (UnitPropagation(decision_level) == ReturnValue::unsat) {
+            is_conflict = true;
+            break;
+        }
+    }
+
+    // LRAT: the shorter clause follows from whatever ended the trial: the conflict,
+    // the reason of the implied literal, or else the clause itself, now false
+    if (is_tracking_ids && proof.isOpen() && vivified.size() < size) {
+        if (is_conflict) {
+            bool is_binary = conflict_clause_number == BINARY_REASON;
+            collectImplicationHints(is_binary ? conflict_binary_clause : clauseLiterals(conflict_clause_number),
+                is_binary ? 2 : clauseSize(conflict_clause_number), -1,
+                is_binary ? binary_clause_ids[binaryClauseKey(conflict_binary_clause[0], conflict_binary_clause[1])]
+                    : clause_ids[conflict_clause_number]);
+        } else if (is_implied) {
+            int variable = literalVariable(vivified.back());
+            int reason_size;
+            Lit binary_literals[2];
+            const Lit* reason_literals = reasonLiterals(variable, reason_size, binary_literals);
+            collectImplicationHints(reason_literals, reason_size, variable, reasonClauseId(variable));
+        } else {
+            collectImplicationHints(literals, size, -1, clause_ids[clause]);
+        }
+    }
+    backtrack(0);
+}
+
+/* one round of vivification at level 0: learned clauses (and input clauses with
+ * vivify_irredundant) are tried in order of LBD, clauses that already went through
+ * a round last, until the round has used vivify_effort times the propagation ticks
+ * search used since the previous round. Returns false if the formula turned out unsat.
+*/
+template <class Branching, class Restart, class Phase>
+bool CDCLSolver<Branching, Restart, Phase>::vivifyClauses() {
+    if (UnitPropagation(0) == ReturnValue::unsat) {
+        refuteFromConflict();
+        return false;
+    }
+    long long search_ticks = propagation_ticks;
+    long long tick_limit = propagation_ticks + (long long) (options.vivify_effort * (propagation_ticks - last_vivification_ticks));
+
+    vector<int> candidates;
+    for (int i = 0; i < formula.size(); i++) {
+        if ((clauseHeader(formula[i]) & CLAUSE_LEARNED) || options.vivify_irredundant) candidates.push_back(i);
+    }
+    sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+        Lit first = clauseHeader(formula[a]), second = clauseHeader(formula[b]);
+        if ((first & CLAUSE_VIVIFIED) != (second & CLAUSE_VIVIFIED)) return !(first & CLAUSE_VIVIFIED);
+        if ((first & CLAUSE_LEARNED) != (second & CLAUSE_LEARNED)) return (first & CLAUSE_LEARNED) != 0;
+        return (first & CLAUSE_LBD_MASK) < (second & CLAUSE_LBD_MASK);
+    });
+
+    vector<char> is_removed(formula.size(), 0);
+    vector<Lit> vivified;
+    bool is_unsat = false;
+    save_phases = false;
+    for (int c = 0; c < candidates.size() && propagation_ticks < tick_limit; c++) {
+        int index = candidates[c];
+        ClauseRef clause = formula[index];
+        const Lit* literals = clauseLiterals(clause);
+        int size = clauseSize(clause);
+        // detached, so the clause cannot propagate its own last literal
+        removeWatch(literals[0], clause);
+        removeWatch(literals[1], clause);
+        bool is_satisfied;
+        vivifyLiterals(clause, vivified, is_satisfied);
+
+        if (!is_satisfied && vivified.size() == size) {
+            watches[literals[0]].push_back({clause, literals[1]});
+            watches[literals[1]].push_back({clause, literals[0]});
+            if (clause >= fixed_clause_end) clause_arena[clause - 1] |= CLAUSE_VIVIFIED;
+            continue;
+        }
+        if (vivified.empty() && !is_satisfied) {
+            // every literal is false at level 0
+            if (proof.isOpen()) logEmptyClause(literals, size, is_tracking_ids ? clause_ids[clause] : 0);
+            is_unsat = true;
+            break;
+        }
+        is_removed[index] = 1;
+        num_formula_literals -= size;
+        num_clauses--;
+        if (is_satisfied) {
+            if (proof.isOpen()) logDeletedClause(clause);
+            continue;
+        }
+
+        // the shortened clause replaces it; none of its literals is assigned at level 0
+        num_formula_literals += vivified.size();
+        num_clauses++;
+        uint64_t vivified_id = proof.isOpen() ? logAddedClause(vivified.data(), vivified.size()) : 0;
+        if (vivified.size() == 1) {
+            assignLiteral(vivified[0], 0, -1);
+            if (is_tracking_ids) unit_clause_ids[literalVariable(vivified[0])] = vivified_id;
+        } else if (vivified.size() == 2) {
+            addBinaryClause(vivified[0], vivified[1], vivified_id);
+        } else {
+            Lit header = clauseHeader(clause);
+            allocateClause(vivified, (header & CLAUSE_LEARNED) != 0, min((int) (header & CLAUSE_LBD_MASK), (int) vivified.size()),
+                vivified_id);
+            clause_arena[formula.back() - 1] |= CLAUSE_VIVIFIED;
+        }
+        if (proof.isOpen()) logDeletedClause(clause);
+        if (vivified.size() == 1 && UnitPropagation(0) == ReturnValue::unsat) {
+            refuteFromConflict();
+            is_unsat = true;
+            break;
+        }
+    }
+    save_phases = true;
+    if (is_unsat) return false;
+
+    // drop the replaced entries (shortened clauses were appended at the end) and reclaim their memory
+    is_removed.resize(formula.size(), 0);
+    int kept = 0;
+    for (int i = 0; i < formula.size(); i++) {
+        if (!is_removed[i]) formula[kept++] = formula[i];
+    }
+    formula.resize(kept);
+    collectGarbage();
+
+    // the round's own ticks do not count as search work
+    propagation_ticks = search_ticks;
+    last_vivification_ticks = propagation_ticks;
+    return !is_unsat;
+}
+
+// literals of the clause that implied an assigned variable; binary_literals holds them for a binary reason
+template <class Branching, class Restart, class Phase>
+const Lit* CDCLSolver<Branching, Restart, Phase>::reasonLiterals(int variable, int& size, Lit* binary_literals) {
+    int reason = variable_assignment_triggering_clause[variable];
+    if (reason == BINARY_REASON) {
+        bool is_negative = literal_values[makeLiteral(variable, true)] == LIT_TRUE;
+        binary_literals[0] = makeLiteral(variable, is_negative);
+        binary_literals[1] = variable_binary_reason[variable];
+        size = 2;
+        return binary_literals;
+    }
+    size = clauseSize(reason);
+    return clauseLiterals(reason);
+}
+
+template <class Branching, class Restart, class Phase>
+uint64_t CDCLSolver<Branching, Restart, Phase>::reasonClauseId(int variable) {
+    int reason = variable_assignment_triggering_clause[variable];
+    if (reason != BINARY_REASON) return clause_ids[reason];
+    bool is_negative = literal_values[makeLiteral(variable, true)] == LIT_TRUE;
+    return binary_clause_ids[binaryClauseKey(makeLiteral(variable, is_negative), variable_binary_reason[variable])];
+}
+
+/* LRAT id of the unit clause of a variable assigned at level 0. Units implied by
+ * propagation get added to the proof the first time one is needed, after the
+ * units their reason depends on.
+*/
+template <class Branching, class Restart, class Phase>
+uint64_t CDCLSolver<Branching, Restart, Phase>::unitClauseId(int variable) {
+    vector<int> pending(1, variable);
+    vector<uint64_t> hints;
+    Lit binary_literals[2];
+    while (!pending.empty()) {
+        int current = pending.back();
+        if (unit_clause_ids[current] != 0) {
+            pending.pop_back();
+            continue;
+        }
+        int size;
+        const Lit* literals = reasonLiterals(current, size, binary_literals);
+        bool is_ready = true;
+        for (int k = 0; k < size; k++) {
+            int other = literalVariable(literals[k]);
+            if (other != current && unit_clause_ids[other] == 0) {
+                pending.push_back(other);
+                is_ready = false;
+            }
+        }
+        if (!is_ready) continue;
+        hints.clear();
+        for (int k = 0; k < size; k++) {
+            if (literalVariable(literals[k]) != current) hints.push_back(unit_clause_ids[literalVariable(literals[k])]);
+        }
+        hints.push_back(reasonClauseId(current));
+        Lit unit = makeLiteral(current, literal_values[makeLiteral(current, true)] == LIT_TRUE);
+        unit_clause_ids[current] = next_clause_id++;
+        proof.addClause(unit_clause_ids[current], &unit, 1, hints);
+        pending.pop_back();
+    }
+    return unit_clause_ids[variable];
+}
+
+/* proof_hints for a clause whose negation, by propagation, falsifies the given clause:
+ * the level 0 units, then the reasons of every propagated literal the clause
+ * depends on in trail order, then the clause itself. skipped_variable (or -1)
+ * is left out of the walk, for a reason clause whose own literal is the one derived.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::collectImplicationHints(const Lit* literals, int size, int skipped_variable, uint64_t clause_id) {
+    vector<int> marked_variables;
+    vector<uint64_t> unit_ids, reason_ids;
+    for (int k = 0; k < size; k++) {
+        int variable = literalVariable(literals[k]);
+        if (variable == skipped_variable || seen[variable]) continue;
+        seen[variable] = 1;
+        marked_variables.push_back(variable);
+    }
+    Lit binary_literals[2];
+    for (int i = (int) trail.size() - 1; i >= 0; i--) {
+        int variable = literalVariable(trail[i]);
+        if (!seen[variable] || variable_assignment_decision_level[variable] == 0) continue;
+        if (variable_assignment_triggering_clause[variable] == -1) continue;
+        reason_ids.push_back(reasonClauseId(variable));
+        int reason_size;
+        const Lit* reason_literals = reasonLiterals(variable, reason_size, binary_literals);
+        for (int k = 0; k < reason_size; k++) {
+            int other = literalVariable(reason_literals[k]);
+            if (seen[other]) continue;
+            seen[other] = 1;
+            marked_variables.push_back(other);
+        }
+    }
+    for (int i = 0; i < marked_variables.size(); i++) {
+        int variable = marked_variables[i];
+        seen[variable] = 0;
+        if (variable_assignment_decision_level[variable] == 0) unit_ids.push_back(unitClauseId(variable));
+    }
+    proof_hints = unit_ids;
+    proof_hints.insert(proof_hints.end(), reason_ids.rbegin(), reason_ids.rend());
+    proof_hints.push_back(clause_id);
+}
+
+// adds a derived clause to the proof, with proof_hints as its LRAT hints; returns its LRAT id
+template <class Branching, class Restart, class Phase>
+uint64_t CDCLSolver<Branching, Restart, Phase>::logAddedClause(const Lit* literals, int size) {
+    if (!is_tracking_ids) {
+        proof.addClause(literals, size);
+        return 0;
+    }
+    uint64_t id = next_clause_id++;
+    proof.addClause(id, literals, size, proof_hints);
+    return id;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::logDeletedClause(ClauseRef clause) {
+    if (!is_tracking_ids) {
+        proof.deleteClause(clauseLiterals(clause), clauseSize(clause));
+        return;
+    }
+    // a level 0 literal keeps needing the clause that implied it, as a unit of its own
+    if (isReason(clause)) unitClauseId(literalVariable(clauseLiterals(clause)[0]));
+    proof.deleteClause(clause_ids[clause]);
+}
+
+// ends the proof with the empty clause, given a clause all of whose literals are false at level 0
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::logEmptyClause(const Lit* literals, int size, uint64_t clause_id) {
+    if (is_tracking_ids) {
+        proof_hints.clear();
+        for (int k = 0; k < size; k++) proof_hints.push_back(unitClauseId(literalVariable(literals[k])));
+        proof_hints.push_back(clause_id);
+    }
+    logAddedClause(nullptr, 0);
+}
+
+// the conflict found by propagation lies entirely at level 0
+template <class Branching, class Restart, class Phase>
+ReturnValue CDCLSolver<Branching, Restart, Phase>::refuteFromConflict() {
+    if (!proof.isOpen()) return ReturnValue::unsat;
+    if (conflict_clause_number == BINARY_REASON) {
+        logEmptyClause(conflict_binary_clause, 2,
+            is_tracking_ids ? binary_clause_ids[binaryClauseKey(conflict_binary_clause[0], conflict_binary_clause[1])] : 0);
+    } else {
+        logEmptyClause(clauseLiterals(conflict_clause_number), clauseSize(conflict_clause_number),
+            is_tracking_ids ? clause_ids[conflict_clause_number] : 0);
+    }
+    return ReturnValue::unsat;
+}
+
+// the clause is the reason of its first literal, which the propagating and learning code keep in front
+template <class Branching, class Restart, class Phase>
+bool CDCLSolver<Branching, Restart, Phase>::isReason(ClauseRef clause) {
+    Lit first = clauseLiterals(clause)[0];
+    return literal_values[first] == LIT_TRUE
+        && variable_assignment_triggering_clause[literalVariable(first)] == (int) clause;
+}
+
+/* deletes half of the learned clauses that are worth least: clauses with an LBD
+ * of at most CORE_CLAUSE_LBD, clauses used in conflict analysis since the last
+ * reduction and reasons are kept, the rest is ranked by LBD, newest first among equals.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::reduceLearnedClauses() {
+    vector<ClauseRef> candidates;
+    int kept = 0;
+    for (int i = 0; i < formula.size(); i++) {
+        ClauseRef clause = formula[i];
+        Lit header = clauseHeader(clause);
+        bool is_kept = !(header & CLAUSE_LEARNED) || (header & CLAUSE_LBD_MASK) <= CORE_CLAUSE_LBD
+            || (header & CLAUSE_USED) || isReason(clause);
+        if (clause >= fixed_clause_end) clause_arena[clause - 1] &= ~CLAUSE_USED;
+        if (is_kept) formula[kept++] = clause;
+        else candidates.push_back(clause);
+    }
+    // clauses are allocated in order, so newer clauses have larger offsets
+    sort(candidates.begin(), candidates.end(), [this](ClauseRef a, ClauseRef b) {
+        Lit first = clause_arena[a - 1] & CLAUSE_LBD_MASK, second = clause_arena[b - 1] & CLAUSE_LBD_MASK;
+        if (first != second) return first < second;
+        return a > b;
+    });
+    int num_kept_candidates = candidates.size() / 2;
+    for (int i = 0; i < candidates.size(); i++) {
+        if (i < num_kept_candidates) {
+            formula[kept++] = candidates[i];
+        } else {
+            num_clauses--;
+            num_formula_literals -= clauseSize(candidates[i]);
+            if (proof.isOpen()) logDeletedClause(candidates[i]);
+        }
+    }
+    formula.resize(kept);
+    collectGarbage();
+}
+
+// copy a live clause to the end of new_arena and leave its new offset in its old size word
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::relocateClause(ClauseRef clause, vector<Lit>& new_arena) {
+    Lit& header = clause_arena[clause - 1];
+    if (!(header & CLAUSE_LIVE) || (header & CLAUSE_RELOCATED)) return;
+    int size = clause_arena[clause];
+    new_arena.push_back(header & ~CLAUSE_LIVE);
+    ClauseRef new_clause = new_arena.size();
+    new_arena.push_back(size);
+    new_arena.insert(new_arena.end(), &clause_arena[clause + 1], &clause_arena[clause + 1] + size);
+    header |= CLAUSE_RELOCATED;
+    clause_arena[clause] = new_clause;
+}
+
+/* mark and compact: the sized clauses still in formula are copied into a fresh
+ * arena, everything else is dropped. Clauses are laid out in the order search
+ * touches them: reasons in trail order, then core clauses (input clauses and
+ * learned ones with a low LBD) in watch list order, then the other learned
+ * clauses in watch list order. Reasons, watchers and formula are then remapped.
+ * The packed fixed-width clauses stay where they are.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::collectGarbage() {
+    size_t live_size = fixed_clause_end;
+    for (int i = 0; i < formula.size(); i++) {
+        if (formula[i] < fixed_clause_end) continue;
+        clause_arena[formula[i] - 1] |= CLAUSE_LIVE;
+        live_size += 2 + clause_arena[formula[i]];
+    }
+    vector<Lit>& new_arena = spare_arena;
+    new_arena.clear();
+    new_arena.reserve(live_size);
+    new_arena.assign(clause_arena.begin(), clause_arena.begin() + fixed_clause_end);
+
+    for (int i = 0; i < trail.size(); i++) {
+        int reason = variable_assignment_triggering_clause[literalVariable(trail[i])];
+        if (reason >= 0 && reason >= fixed_clause_end) relocateClause(reason, new_arena);
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        for (int literal = 0; literal < watches.size(); literal++) {
+            for (int i = 0; i < watches[literal].size(); i++) {
+                ClauseRef clause = watches[literal][i].clause;
+                if (clause == BINARY_CLAUSE || clause < fixed_clause_end) continue;
+                Lit header = clause_arena[clause - 1];
+                bool is_core = !(header & CLAUSE_LEARNED) || (header & CLAUSE_LBD_MASK) <= CORE_CLAUSE_LBD;
+                if (pass == 0 && !is_core) continue;
+                relocateClause(clause, new_arena);
+            }
+        }
+    }
+    // and anything in formula the watch lists did not lead to
+    for (int i = 0; i < formula.size(); i++) {
+        if (formula[i] >= fixed_clause_end) relocateClause(formula[i], new_arena);
+    }
+
+    // a reason that was not moved is a deleted clause that implied a level 0 literal,
+    // which conflict analysis never looks at
+    for (int variable = 0; variable < num_variables; variable++) {
+        int& reason = variable_assignment_triggering_clause[variable];
+        if (reason < 0 || reason < fixed_clause_end) continue;
+        reason = (clause_arena[reason - 1] & CLAUSE_RELOCATED) ? (int) clause_arena[reason] : -1;
+    }
+    for (int literal = 0; literal < watches.size(); literal++) {
+        vector<Watcher>& watch_list = watches[literal];
+        int kept = 0;
+        for (int i = 0; i < watch_list.size(); i++) {
+            ClauseRef clause = watch_list[i].clause;
+            if (clause != BINARY_CLAUSE && clause >= fixed_clause_end) {
+                if (!(clause_arena[clause - 1] & CLAUSE_RELOCATED)) continue;
+                watch_list[i].clause = clause_arena[clause];
+            }
+            watch_list[kept++] = watch_list[i];
+        }
+        watch_list.resize(kept);
+    }
+    vector<uint64_t> new_clause_ids;
+    if (is_tracking_ids) {
+        new_clause_ids.resize(new_arena.size());
+        copy(clause_ids.begin(), clause_ids.begin() + fixed_clause_end, new_clause_ids.begin());
+    }
+    for (int i = 0; i < formula.size(); i++) {
+        if (formula[i] < fixed_clause_end) continue;
+        ClauseRef new_clause = clause_arena[formula[i]];
+        if (is_tracking_ids) new_clause_ids[new_clause] = clause_ids[formula[i]];
+        formula[i] = new_clause;
+    }
+    clause_arena.swap(new_arena);
+    clause_ids.swap(new_clause_ids);
+}
+
+// memory held by the solver's own containers; O(1) so it can be called from the main loop
+template <class Branching, class Restart, class Phase>
+double CDCLSolver<Branching, Restart, Phase>::estimateMemoryMB() {
+    // every clause has two watchers; binary clauses exist only as their watchers
+    size_t bytes = clause_arena.capacity() * sizeof(Lit) + formula.capacity() * sizeof(ClauseRef)
+        + 2 * (size_t) num_clauses * sizeof(Watcher);
+    bytes += (literal_values.capacity() + seen.capacity()) * sizeof(char);
+    bytes += (trail.capacity() + variable_binary_reason.capacity()) * sizeof(Lit);
+    bytes += (variable_occurrences.capacity() + literal_polarity_difference.capacity()
+        + variable_assignment_decision_level.capacity()
+        + variable_assignment_triggering_clause.capacity()) * sizeof(int);
+    return bytes / (1024.0 * 1024.0);
+}
+
+template <class Branching, class Restart, class Phase>
+bool CDCLSolver<Branching, Restart, Phase>::isBudgetExhausted() {
+    if (interrupt_signalled || interrupt_requested.load(memory_order_relaxed)) return true;
+    if (budget.max_conflicts >= 0 && statistics.conflicts >= budget.max_conflicts) return true;
+    if (budget.max_propagations >= 0 && statistics.propagations >= budget.max_propagations) return true;
+    if (budget.max_seconds >= 0) {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+        if (elapsed.count() >= budget.max_seconds) return true;
+    }
+    if (budget.max_memory_mb >= 0 && estimateMemoryMB() >= budget.max_memory_mb) return true;
+    return false;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::setBudget(const SolverBudget& new_budget) {
+    budget = new_budget;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::setOptions(const SolverOptions& new_options) {
+    options = new_options;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::setSeed(uint64_t seed) {
+    random_seed = seed;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::interrupt() {
+    interrupt_requested.store(true, memory_order_relaxed);
+}
+
+template <class Branching, class Restart, class Phase>
+const SolverStatistics& CDCLSolver<Branching, Restart, Phase>::getStatistics() {
+    return statistics;
+}
+
+/* copies what a resumed search needs into the snapshot buffer and hands it to
+ * the writer thread: the branching scores, the level 0 trail, the binary
+ * clauses, the learned clauses of 3+ literals and the phases. A periodic
+ * snapshot is skipped while the writer is still busy with the previous one;
+ * the final one waits for it and is on disk when this returns.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::writeCheckpoint(bool is_final) {
+    if (!is_final && checkpoint_writer.isBusy()) return;
+    next_checkpoint_time = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>(options.checkpoint_interval));
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.num_variables = num_variables;
+    header.formula_hash = formula_hash;
+    header.conflicts = resumed_conflicts + statistics.conflicts;
+    strncpy(header.branching, Branching::name(), sizeof(header.branching) - 1);
+
+    // the header goes in last, once the section sizes are known
+    vector<char>& buffer = checkpoint_writer.startSnapshot();
+    buffer.resize(sizeof(SnapshotHeader));
+    branching.exportScores(snapshot_scores);
+    appendSnapshotData(buffer, snapshot_scores.data(), num_variables);
+    // with chronological backtracking level 0 literals can sit anywhere on the trail
+    for (int i = 0; i < trail.size(); i++) {
+        if (variable_assignment_decision_level[literalVariable(trail[i])] != 0) continue;
+        appendSnapshotData(buffer, &trail[i], 1);
+        header.num_units++;
+    }
+    for (Lit literal = 0; literal < watches.size(); literal++) {
+        for (int i = 0; i < watches[literal].size(); i++) {
+            // each binary clause is listed under both its literals
+            const Watcher& watcher = watches[literal][i];
+            if (watcher.clause != BINARY_CLAUSE || watcher.blocker < literal) continue;
+            Lit binary[2] = {literal, watcher.blocker};
+            appendSnapshotData(buffer, binary, 2);
+            header.num_binaries++;
+        }
+    }
+    for (int i = 0; i < formula.size(); i++) {
+        Lit clause_header = clauseHeader(formula[i]);
+        if (!(clause_header & CLAUSE_LEARNED)) continue;
+        Lit sizes[2] = {clause_header & CLAUSE_LBD_MASK, (Lit) clauseSize(formula[i])};
+        appendSnapshotData(buffer, sizes, 2);
+        appendSnapshotData(buffer, clauseLiterals(formula[i]), sizes[1]);
+        header.num_clause_words += 2 + sizes[1];
+    }
+    for (int variable = 0; variable < num_variables; variable++) {
+        signed char is_negative = phases.pickNegative(variable, literal_polarity_difference);
+        appendSnapshotData(buffer, &is_negative, 1);
+    }
+    memcpy(buffer.data(), &header, sizeof(SnapshotHeader));
+
+    checkpoint_writer.submit();
+    if (is_final) checkpoint_writer.wait();
+}
+
+/* imports a snapshot taken on the same formula: its level 0 units become unit
+ * clauses, its binary and learned clauses are added as learned clauses, and
+ * phases and (for the same branching policy) scores replace the fresh ones.
+ * Without a usable snapshot the search just starts from scratch.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::resumeFromSnapshot() {
+    SnapshotMapping snapshot;
+    string failure;
+    if (!snapshot.map(options.resume_path, failure)) {
+        cerr << failure << ", starting from scratch" << endl;
+        return;
+    }
+    const SnapshotHeader& header = *snapshot.header;
+    if (header.num_variables != num_variables || header.formula_hash != formula_hash) {
+        cerr << "snapshot " << options.resume_path << " was taken on another formula, starting from scratch" << endl;
+        return;
+    }
+    // the proof would use the imported clauses without deriving them
+    if (proof.isOpen()) {
+        cerr << "snapshot clauses cannot be justified in a proof, starting from scratch" << endl;
+        return;
+    }
+    // check every literal and clause size before importing any of them
+    Lit num_literals = 2 * num_variables;
+    bool is_valid = true;
+    for (uint64_t i = 0; i < header.num_units && is_valid; i++) is_valid = snapshot.units[i] < num_literals;
+    for (uint64_t i = 0; i < 2 * header.num_binaries && is_valid; i++) is_valid = snapshot.binaries[i] < num_literals;
+    uint64_t num_long_clauses = 0;
+    for (uint64_t i = 0; i < header.num_clause_words && is_valid; num_long_clauses++) {
+        Lit size = i + 1 < header.num_clause_words ? snapshot.clause_words[i + 1] : 0;
+        is_valid = size >= 3 && size <= header.num_clause_words - i - 2;
+        for (Lit k = 0; k < size && is_valid; k++) is_valid = snapshot.clause_words[i + 2 + k] < num_literals;
+        i += 2 + size;
+    }
+    if (!is_valid) {
+        cerr << "snapshot " << options.resume_path << " is corrupt, starting from scratch" << endl;
+        return;
+    }
+
+    unit_clauses.insert(unit_clauses.end(), snapshot.units, snapshot.units + header.num_units);
+    // the snapshot repeats the binary clauses of the input
+    unordered_set<uint64_t> binary_keys;
+    for (Lit literal = 0; literal < watches.size(); literal++) {
+        for (int i = 0; i < watches[literal].size(); i++) {
+            if (watches[literal][i].clause == BINARY_CLAUSE) binary_keys.insert(binaryClauseKey(literal, watches[literal][i].blocker));
+        }
+    }
+    for (uint64_t i = 0; i < header.num_binaries; i++) {
+        Lit first = snapshot.binaries[2 * i], second = snapshot.binaries[2 * i + 1];
+        if (!binary_keys.insert(binaryClauseKey(first, second)).second) continue;
+        addBinaryClause(first, second);
+        num_clauses++;
+    }
+    vector<Lit>& clause = input_clause;
+    for (uint64_t i = 0; i < header.num_clause_words; i += 2 + snapshot.clause_words[i + 1]) {
+        clause.assign(snapshot.clause_words + i + 2, snapshot.clause_words + i + 2 + snapshot.clause_words[i + 1]);
+        allocateClause(clause, true, snapshot.clause_words[i]);
+        num_clauses++;
+        num_formula_literals += clause.size();
+    }
+    if (strncmp(header.branching, Branching::name(), sizeof(header.branching)) == 0) {
+        snapshot_scores.assign(snapshot.scores, snapshot.scores + num_variables);
+        branching.importScores(snapshot_scores);
+    }
+    for (int variable = 0; variable < num_variables; variable++) phases.setPhase(variable, snapshot.phases[variable] != 0);
+    resumed_conflicts = header.conflicts;
+    cerr << "c resumed from " << options.resume_path << " after " << header.conflicts << " conflicts: "
+         << header.num_units << " level 0 literals, " << header.num_binaries << " binary and "
+         << num_long_clauses << " learned clauses" << endl;
+}
+
+/* hints become the saved phases (over those of a snapshot) and, with
+ * options.hint_bias, raise the branching scores of their variables. Search
+ * then decides them first, in order: if they are a model, propagation
+ * confirms it without a conflict and search returns SAT right away.
+*/
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::applyHints() {
+    for (int i = 0; i < hint_literals.size(); i++) {
+        phases.setPhase(literalVariable(hint_literals[i]), isNegativeLiteral(hint_literals[i]));
+    }
+    if (options.hint_bias <= 0) return;
+    branching.exportScores(snapshot_scores);
+    double highest_score = 0;
+    for (int v = 0; v < num_variables; v++) highest_score = max(highest_score, snapshot_scores[v]);
+    // even with all scores at 0, a bias of 1 or more ranks the hinted variables first
+    double bias = options.hint_bias * max(highest_score, 1.0);
+    for (int i = 0; i < hint_literals.size(); i++) snapshot_scores[literalVariable(hint_literals[i])] += bias;
+    branching.importScores(snapshot_scores);
+}
+
+template <class Branching, class Restart, class Phase>
+ReturnValue CDCLSolver<Branching, Restart, Phase>::search() {
+    statistics = SolverStatistics();
+    interrupt_requested.store(false, memory_order_relaxed);
+    solve_start_time = chrono::steady_clock::now();
+
+    if (!options.proof_path.empty()) {
+        // LRAT ids are only known if the options were already set at load()
+        ProofFormat format = is_tracking_ids ? ProofFormat::lrat : ProofFormat::drat;
+        if (options.proof_lrat && !is_tracking_ids) cerr << "LRAT needs the proof options before loading, writing DRAT" << endl;
+        if (!proof.open(options.proof_path, format)) {
+            cerr << "cannot write proof to " << options.proof_path << endl;
+            statistics.proof_write_failed = true;
+            is_tracking_ids = false;
+        }
+    }
+    if (!is_preprocessed && !has_empty_clause && options.blocked_clause_elimination) eliminateClauses();
+    is_preprocessed = true;
+    // imported clauses go in after preprocessing and before anything is assigned
+    if (!has_tried_resume && !options.resume_path.empty() && trail.empty()) resumeFromSnapshot();
+    has_tried_resume = true;
+    if (!hint_literals.empty()) applyHints();
+    if (!options.checkpoint_path.empty()) {
+        checkpoint_writer.open(options.checkpoint_path);
+        next_checkpoint_check = CHECKPOINT_CHECK_CONFLICTS;
+        next_checkpoint_time = solve_start_time + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(options.checkpoint_interval));
+    }
+    ReturnValue result = runCDCL();
+    if (checkpoint_writer.isOpen()) {
+        // a search cut short leaves a snapshot of where it stopped
+        if (result == ReturnValue::unknown) writeCheckpoint(true);
+        checkpoint_writer.close();
+    }
+    if (result == ReturnValue::sat && clause_eliminator.hasEliminated()) {
+        // reconstruction needs a total assignment; unassigned variables read as false anyway
+        for (int variable = 0; variable < num_variables; variable++) {
+            if (literal_values[makeLiteral(variable, false)] != LIT_UNASSIGNED) continue;
+            literal_values[makeLiteral(variable, false)] = LIT_FALSE;
+            literal_values[makeLiteral(variable, true)] = LIT_TRUE;
+        }
+        clause_eliminator.extendModel(literal_values);
+    }
+    if (!proof.close()) statistics.proof_write_failed = true;
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+    statistics.seconds = elapsed.count();
+    statistics.memory_mb = estimateMemoryMB();
+    return result;
+}
+
+template <class Branching, class Restart, class Phase>
+int CDCLSolver<Branching, Restart, Phase>::numVariables() {
+    return num_variables;
+}
+
+// unassigned variables (which at this stage can take any value) read as false
+template <class Branching, class Restart, class Phase>
+bool CDCLSolver<Branching, Restart, Phase>::modelValue(int variable) {
+    return literal_values[makeLiteral(variable, false)] == LIT_TRUE;
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::suggestPhase(int variable, bool is_negative) {
+    phases.setPhase(variable, is_negative);
+}
+
+template <class Branching, class Restart, class Phase>
+void CDCLSolver<Branching, Restart, Phase>::suggestAssignment(const vector<Lit>& literals) {
+    hint_literals.clear();
+    for (int i = 0; i < literals.size(); i++) {
+        if (literalVariable(literals[i]) < num_variables) hint_literals.push_back(literals[i]);
+    }
+}
+
+#endif
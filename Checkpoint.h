@@ -0,0 +1,262 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SolverCommon.h"
+
+/* Snapshots of a CDCL search, so a run that is stopped (time limit, SIGINT,
+ * SIGTERM from a batch scheduler) can be resumed by a later run on the same
+ * formula with its learned clauses, variable scores and phases.
+ *
+ * File layout: a SnapshotHeader, then
+ *   double       scores[num_variables]       branching scores, higher first
+ *   Lit          units[num_units]            level 0 trail
+ *   Lit          binaries[2 * num_binaries]  binary clauses
+ *   Lit          clause_words[num_clause_words]  learned clauses as [lbd][size][literals]
+ *   signed char  phases[num_variables]       1 negative, 0 positive
+ * in native byte order; a snapshot is only ever read back on the machine type
+ * that wrote it. The header is a multiple of 8 bytes, so the scores are
+ * aligned and a mapped file is read in place.
+ *
+ * Writing is double buffered: search copies its state into a buffer and hands
+ * it to a writer thread, which hashes it, writes it to <path>.tmp and renames
+ * that over <path>, so a reader only ever sees complete snapshots. While the
+ * writer is still busy with the previous snapshot, a periodic one is skipped
+ * instead of stalling search.
+*/
+
+const uint32_t SNAPSHOT_VERSION = 1;
+const char SNAPSHOT_MAGIC[8] = {'S', 'A', 'T', 'S', 'N', 'A', 'P', 0};
+// conflicts between looks at the clock for a due snapshot
+const long long CHECKPOINT_CHECK_CONFLICTS = 1000;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    int32_t num_variables;
+    uint64_t formula_hash;
+    // FNV-1a of everything after the header
+    uint64_t payload_hash;
+    // conflicts of all the runs that led to this snapshot
+    uint64_t conflicts;
+    uint64_t num_units;
+    uint64_t num_binaries;
+    uint64_t num_clause_words;
+    // name of the branching policy the scores belong to
+    char branching[16];
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "snapshot scores must stay aligned");
+
+inline uint64_t fnv1aHash(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// identifies a formula: its variable count, clause boundaries and literals
+inline uint64_t formulaHash(const CNFFormula& formula) {
+    uint64_t hash = fnv1aHash((const char*) &formula.num_variables, sizeof(formula.num_variables));
+    hash = fnv1aHash((const char*) formula.clause_start.data(), formula.clause_start.size() * sizeof(int), hash);
+    return fnv1aHash((const char*) formula.literals.data(), formula.literals.size() * sizeof(Lit), hash);
+}
+
+template <class T>
+void appendSnapshotData(vector<char>& buffer, const T* data, size_t count) {
+    const char* bytes = (const char*) data;
+    buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+class SnapshotWriter
+{
+    string path;
+    // filled by search, then swapped with the one the writer thread owns
+    vector<char> buffer;
+    vector<char> written;
+    bool has_pending = false;
+    bool is_closing = false;
+    bool has_failed = false;
+    mutex state_mutex;
+    condition_variable has_work;
+    condition_variable is_idle;
+    thread writer;
+
+    void writerLoop();
+
+public:
+    ~SnapshotWriter() { close(); }
+
+    void open(const string& snapshot_path);
+    bool isOpen() const { return writer.joinable(); }
+    // a snapshot handed over earlier is still being written
+    bool isBusy();
+    // the buffer to serialize the next snapshot into, header first
+    vector<char>& startSnapshot() {
+        buffer.clear();
+        return buffer;
+    }
+    // hands the filled buffer to the writer thread, once it is done with the previous one
+    void submit();
+    // blocks until the writer is done with what was submitted
+    void wait();
+    void close();
+};
+
+inline void SnapshotWriter::open(const string& snapshot_path) {
+    close();
+    path = snapshot_path;
+    is_closing = false;
+    has_pending = false;
+    has_failed = false;
+    writer = thread(&SnapshotWriter::writerLoop, this);
+}
+
+inline bool SnapshotWriter::isBusy() {
+    lock_guard<mutex> guard(state_mutex);
+    return has_pending;
+}
+
+inline void SnapshotWriter::submit() {
+    {
+        unique_lock<mutex> guard(state_mutex);
+        is_idle.wait(guard, [this] { return !has_pending; });
+        buffer.swap(written);
+        has_pending = true;
+    }
+    has_work.notify_one();
+}
+
+inline void SnapshotWriter::wait() {
+    unique_lock<mutex> guard(state_mutex);
+    is_idle.wait(guard, [this] { return !has_pending; });
+}
+
+inline void SnapshotWriter::writerLoop() {
+    unique_lock<mutex> guard(state_mutex);
+    while (true) {
+        has_work.wait(guard, [this] { return has_pending || is_closing; });
+        if (!has_pending) return;
+        // search does not touch the written buffer until has_pending is cleared
+        guard.unlock();
+        SnapshotHeader* header = (SnapshotHeader*) written.data();
+        header->payload_hash = fnv1aHash(written.data() + sizeof(SnapshotHeader), written.size() - sizeof(SnapshotHeader));
+        string temporary_path = path + ".tmp";
+        FILE* file = fopen(temporary_path.c_str(), "wb");
+        bool is_written = file && fwrite(written.data(), 1, written.size(), file) == written.size();
+        if (file) is_written = fflush(file) == 0 && fsync(fileno(file)) == 0 && is_written;
+        if (file) fclose(file);
+        is_written = is_written && rename(temporary_path.c_str(), path.c_str()) == 0;
+        if (!is_written && !has_failed) cerr << "cannot write snapshot " << path << endl;
+        guard.lock();
+        has_failed = has_failed || !is_written;
+        has_pending = false;
+        is_idle.notify_all();
+    }
+}
+
+inline void SnapshotWriter::close() {
+    if (!writer.joinable()) return;
+    {
+        lock_guard<mutex> guard(state_mutex);
+        is_closing = true;
+    }
+    has_work.notify_one();
+    writer.join();
+}
+
+/* a snapshot file mapped read-only; the section pointers point into the
+ * mapping and stay valid until it is unmapped
+*/
+class SnapshotMapping
+{
+    void* mapping = MAP_FAILED;
+    size_t mapping_size = 0;
+
+public:
+    const SnapshotHeader* header = nullptr;
+    const double* scores = nullptr;
+    const Lit* units = nullptr;
+    const Lit* binaries = nullptr;
+    const Lit* clause_words = nullptr;
+    const signed char* phases = nullptr;
+
+    ~SnapshotMapping() { unmap(); }
+
+    // false with a reason if the file is missing, truncated or corrupt
+    bool map(const string& path, string& failure);
+    void unmap();
+};
+
+inline bool SnapshotMapping::map(const string& path, string& failure) {
+    unmap();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        failure = "no snapshot " + path;
+        return false;
+    }
+    struct stat file_status;
+    if (fstat(fd, &file_status) != 0 || file_status.st_size < (off_t) sizeof(SnapshotHeader)) {
+        ::close(fd);
+        failure = "snapshot " + path + " is truncated";
+        return false;
+    }
+    mapping_size = file_status.st_size;
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive by itself
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        failure = "cannot map snapshot " + path;
+        return false;
+    }
+
+    const char* data = (const char*) mapping;
+    header = (const SnapshotHeader*) data;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header->version != SNAPSHOT_VERSION
+        || header->num_variables < 0) {
+        failure = path + " is not a snapshot of this version";
+        unmap();
+        return false;
+    }
+    uint64_t num_variables = header->num_variables;
+    uint64_t expected_size = sizeof(SnapshotHeader) + num_variables * sizeof(double) + num_variables
+        + (header->num_units + 2 * header->num_binaries + header->num_clause_words) * sizeof(Lit);
+    // the section counts come from the file, so guard the sum against wrapping around as well
+    if (header->num_units > mapping_size || header->num_binaries > mapping_size || header->num_clause_words > mapping_size
+        || expected_size != mapping_size
+        || fnv1aHash(data + sizeof(SnapshotHeader), mapping_size - sizeof(SnapshotHeader)) != header->payload_hash) {
+        failure = "snapshot " + path + " is corrupt";
+        unmap();
+        return false;
+    }
+    const char* section = data + sizeof(SnapshotHeader);
+    scores = (const double*) section;
+    section += num_variables * sizeof(double);
+    units = (const Lit*) section;
+    section += header->num_units * sizeof(Lit);
+    binaries = (const Lit*) section;
+    section += 2 * header->num_binaries * sizeof(Lit);
+    clause_words = (const Lit*) section;
+    section += header->num_clause_words * sizeof(Lit);
+    phases = (const signed char*) section;
+    return true;
+}
+
+inline void SnapshotMapping::unmap() {
+    if (mapping != MAP_FAILED) munmap(mapping, mapping_size);
+    mapping = MAP_FAILED;
+    mapping_size = 0;
+    header = nullptr;
+}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef CLAUSE_ELIMINATION_H
+#define CLAUSE_ELIMINATION_H
+
+#include "SolverCommon.h"
+
+/* Blocked clause elimination (BCE) and covered clause elimination (CCE), run on
+ * a formula before search.
+ * A clause C is blocked on one of its literals l if every resolvent of C on l is
+ * a tautology, i.e. every clause containing -l also contains the negation of
+ * another literal of C. Dropping C keeps the formula satisfiable, and a model of
+ * what is left becomes a model of C by making l true.
+ * CCE first grows C by covered literals: the literals that every
+ * non-tautological resolution partner of C on l shares (besides -l). The grown
+ * clause can stand in for C, and once it is blocked C is dropped.
+ * Every removal pushes (clause, witness) entries on a reconstruction stack;
+ * extendModel() walks it backwards and makes the witness true wherever its
+ * clause is false.
+*/
+
+// work allowed per literal of the input, keeps preprocessing linear
+const long long CLAUSE_ELIMINATION_STEPS_PER_LITERAL = 20;
+// covered literal addition gives up on a clause once it grows past this size
+const int MAX_COVERED_CLAUSE_SIZE = 64;
+
+class ClauseEliminator
+{
+    struct ReconstructionEntry
+    {
+        Lit witness;
+        int start;  // clause is reconstruction_literals[start .. start + size)
+        int size;
+    };
+
+    vector<vector<Lit>> clauses;
+    vector<char> is_removed;
+    // occurrences[literal]: clauses containing it; removed clauses stay listed and are skipped
+    vector<vector<int>> occurrences;
+    // literals whose clauses are to be tested for being blocked on them
+    vector<Lit> touched_literals;
+    vector<char> is_touched;
+    // marks the literals of the clause under test
+    vector<char> marked;
+    // CCE: number of resolution partners each literal occurs in
+    vector<int> partner_count;
+    vector<ReconstructionEntry> reconstruction_stack;
+    vector<Lit> reconstruction_literals;
+    long long steps;
+    long long step_limit;
+
+    bool isTautologicalResolvent(const vector<Lit>& partner, Lit literal);
+    bool isBlockedOn(Lit literal);
+    void touch(Lit literal);
+    void pushReconstruction(const vector<Lit>& clause, Lit witness);
+    void eliminateBlocked();
+    bool eliminateCovered(int clause);
+
+public:
+    int num_blocked = 0;
+    int num_covered = 0;
+
+    // removes blocked clauses from formula, then covered ones if asked to
+    void eliminate(CNFFormula& formula, bool covered);
+    // turns a total assignment satisfying the reduced formula into one satisfying the original
+    void extendModel(vector<signed char>& literal_values) const;
+    bool hasEliminated() const { return !reconstruction_stack.empty(); }
+    // whether clause i of the formula last given to eliminate() was removed
+    bool isRemoved(int clause) const { return is_removed[clause]; }
+    void clear();
+};
+
+// the resolvent of the marked clause with partner on literal has a complementary pair
+inline bool ClauseEliminator::isTautologicalResolvent(const vector<Lit>& partner, Lit literal) {
+    steps += partner.size();
+    for (int k = 0; k < partner.size(); k++) {
+        if (partner[k] != negateLiteral(literal) && marked[negateLiteral(partner[k])]) return true;
+    }
+    return false;
+}
+
+// the marked clause is blocked on literal
+inline bool ClauseEliminator::isBlockedOn(Lit literal) {
+    const vector<int>& partners = occurrences[negateLiteral(literal)];
+    steps += 1 + partners.size();
+    for (int i = 0; i < partners.size(); i++) {
+        if (is_removed[partners[i]]) continue;
+        if (!isTautologicalResolvent(clauses[partners[i]], literal)) return false;
+    }
+    return true;
+}
+
+inline void ClauseEliminator::touch(Lit literal) {
+    if (is_touched[literal]) return;
+    is_touched[literal] = 1;
+    touched_literals.push_back(literal);
+}
+
+inline void ClauseEliminator::pushReconstruction(const vector<Lit>& clause, Lit witness) {
+    reconstruction_stack.push_back({witness, (int) reconstruction_literals.size(), (int) clause.size()});
+    reconstruction_literals.insert(reconstruction_literals.end(), clause.begin(), clause.end());
+}
+
+/* worklist BCE: the clauses of a touched literal are tested for being blocked on it.
+ * Removing a clause never unblocks another one. It can only block clauses
+ * containing the negation of one of its literals, so those negations get touched.
+*/
+inline void ClauseEliminator::eliminateBlocked() {
+    while (!touched_literals.empty() && steps < step_limit) {
+        Lit literal = touched_literals.back();
+        touched_literals.pop_back();
+        is_touched[literal] = 0;
+        const vector<int>& candidates = occurrences[literal];
+        for (int i = 0; i < candidates.size() && steps < step_limit; i++) {
+            int clause = candidates[i];
+            if (is_removed[clause]) continue;
+            const vector<Lit>& literals = clauses[clause];
+            for (int k = 0; k < literals.size(); k++) marked[literals[k]] = 1;
+            bool is_blocked = isBlockedOn(literal);
+            for (int k = 0; k < literals.size(); k++) marked[literals[k]] = 0;
+            if (!is_blocked) continue;
+
+            is_removed[clause] = 1;
+            num_blocked++;
+            pushReconstruction(literals, literal);
+            for (int k = 0; k < literals.size(); k++) touch(negateLiteral(literals[k]));
+        }
+    }
+}
+
+/* grows the clause by covered literals until it is blocked (then it is removed),
+ * nothing more can be added, or it gets too long. Each growth step on a literal l
+ * pushes (clause before the step, l) on the reconstruction stack, so
+ * reconstruction undoes the steps last to first.
+*/
+inline bool ClauseEliminator::eliminateCovered(int clause) {
+    vector<Lit> extended = clauses[clause];
+    for (int k = 0; k < extended.size(); k++) marked[extended[k]] = 1;
+    int stack_size = reconstruction_stack.size();
+    int stack_literals = reconstruction_literals.size();
+    Lit witness = 0;
+    bool is_blocked = false;
+    bool has_grown = true;
+    vector<Lit> counted;
+    vector<Lit> covered;
+
+    while (has_grown && !is_blocked && steps < step_limit && extended.size() <= MAX_COVERED_CLAUSE_SIZE) {
+        has_grown = false;
+        for (int position = 0; position < extended.size() && !is_blocked; position++) {
+            Lit literal = extended[position];
+            const vector<int>& partners = occurrences[negateLiteral(literal)];
+            steps += 1 + partners.size();
+            int num_partners = 0;
+            for (int i = 0; i < partners.size(); i++) {
+                const vector<Lit>& partner = clauses[partners[i]];
+                if (is_removed[partners[i]] || isTautologicalResolvent(partner, literal)) continue;
+                num_partners++;
+                for (int k = 0; k < partner.size(); k++) {
+                    if (partner[k] == negateLiteral(literal)) continue;
+                    if (partner_count[partner[k]]++ == 0) counted.push_back(partner[k]);
+                }
+            }
+            covered.clear();
+            for (int i = 0; i < counted.size(); i++) {
+                if (partner_count[counted[i]] == num_partners && !marked[counted[i]]) covered.push_back(counted[i]);
+                partner_count[counted[i]] = 0;
+            }
+            counted.clear();
+
+            if (num_partners == 0) {
+                is_blocked = true;
+                witness = literal;
+            } else if (!covered.empty()) {
+                pushReconstruction(extended, literal);
+                for (int i = 0; i < covered.size(); i++) {
+                    extended.push_back(covered[i]);
+                    marked[covered[i]] = 1;
+                }
+                has_grown = true;
+            }
+        }
+    }
+    for (int k = 0; k < extended.size(); k++) marked[extended[k]] = 0;
+
+    if (!is_blocked) {
+        reconstruction_stack.resize(stack_size);
+        reconstruction_literals.resize(stack_literals);
+        return false;
+    }
+    pushReconstruction(extended, witness);
+    is_removed[clause] = 1;
+    num_covered++;
+    return true;
+}
+
+inline void ClauseEliminator::eliminate(CNFFormula& formula, bool covered) {
+    int num_literals = 2 * formula.num_variables;
+    clauses.resize(formula.numClauses());
+    is_removed.assign(formula.numClauses(), 0);
+    occurrences.assign(num_literals, vector<int>());
+    for (int c = 0; c < formula.numClauses(); c++) {
+        clauses[c].assign(formula.clauseLiterals(c), formula.clauseLiterals(c) + formula.clauseSize(c));
+        for (int k = 0; k < clauses[c].size(); k++) occurrences[clauses[c][k]].push_back(c);
+    }
+    marked.assign(num_literals, 0);
+    partner_count.assign(num_literals, 0);
+    is_touched.assign(num_literals, 1);
+    touched_literals.clear();
+    for (Lit literal = 0; literal < num_literals; literal++) touched_literals.push_back(literal);
+    steps = 0;
+    step_limit = CLAUSE_ELIMINATION_STEPS_PER_LITERAL * (long long) formula.literals.size();
+
+    eliminateBlocked();
+    if (covered) {
+        for (int c = 0; c < clauses.size() && steps < step_limit; c++) {
+            if (!is_removed[c]) eliminateCovered(c);
+        }
+    }
+
+    formula.literals.clear();
+    formula.clause_start.assign(1, 0);
+    for (int c = 0; c < clauses.size(); c++) {
+        if (!is_removed[c]) formula.addClause(clauses[c]);
+    }
+    // only the reconstruction stack is needed from here on
+    vector<vector<Lit>>().swap(clauses);
+    vector<vector<int>>().swap(occurrences);
+}
+
+inline void ClauseEliminator::extendModel(vector<signed char>& literal_values) const {
+    for (int e = (int) reconstruction_stack.size() - 1; e >= 0; e--) {
+        const ReconstructionEntry& entry = reconstruction_stack[e];
+        bool is_satisfied = false;
+        for (int k = 0; k < entry.size && !is_satisfied; k++) {
+            is_satisfied = literal_values[reconstruction_literals[entry.start + k]] == LIT_TRUE;
+        }
+        if (is_satisfied) continue;
+        literal_values[entry.witness] = LIT_TRUE;
+        literal_values[negateLiteral(entry.witness)] = LIT_FALSE;
+    }
+}
+
+inline void ClauseEliminator::clear() {
+    reconstruction_stack.clear();
+    reconstruction_literals.clear();
+    num_blocked = 0;
+    num_covered = 0;
+}
+
+#endif
@@ -0,0 +1,465 @@
+#ifndef ENGINE_SELECTION_H
+#define ENGINE_SELECTION_H
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include "SolverCommon.h"
+#include "BruteForce.h"
+
+/* Picks the engine for a formula from cheap features of the formula itself,
+ * instead of by hand per test directory.
+ *
+ * The features are taken in one pass over the parsed formula, plus a short
+ * round of failed literal probing on the most frequent variables:
+ *  - size: variables, clauses and their ratio
+ *  - clause length histogram: fractions of unit, binary, ternary and longer
+ *    clauses, the mean length, and the width if every clause has the same one
+ *  - variable occurrences: mean and coefficient of variation
+ *  - polarity balance: mean of |positive - negative| / occurrences per
+ *    variable, the literal_polarity_difference the CDCL phases start from
+ *  - probing: fraction of probed literals that fail, and the fraction of the
+ *    variables a probe implies on average
+ *
+ * A selector maps the features to a solver name as createSolver() takes it.
+ * RuleSelector encodes what the test families show; NearestNeighbourSelector
+ * answers with the engine of the closest instance in a file of solved ones.
+*/
+
+// probing gives up after this many clause visits per input literal (at least FEATURE_MIN_PROBE_TICKS)
+const long long FEATURE_PROBE_TICKS_PER_LITERAL = 4;
+const long long FEATURE_MIN_PROBE_TICKS = 100000;
+// variables probed, in order of decreasing occurrences
+const int FEATURE_PROBE_VARIABLES = 64;
+
+struct InstanceFeatures
+{
+    int num_variables = 0;
+    int num_clauses = 0;
+    double clause_variable_ratio = 0;
+    double unit_fraction = 0;
+    double binary_fraction = 0;
+    double ternary_fraction = 0;
+    double long_fraction = 0;
+    double mean_clause_length = 0;
+    // length shared by every clause, 0 if lengths differ
+    int fixed_width = 0;
+    double occurrence_mean = 0;
+    double occurrence_variation = 0;
+    double polarity_balance = 0;
+    double failed_literal_fraction = 0;
+    double probe_implied_fraction = 0;
+    // unit propagation of the unit clauses alone already conflicts
+    bool has_root_conflict = false;
+
+    // the features as one vector, in the order of names()
+    vector<double> values() const {
+        return {(double) num_variables, (double) num_clauses, clause_variable_ratio,
+                unit_fraction, binary_fraction, ternary_fraction, long_fraction,
+                mean_clause_length, (double) fixed_width, occurrence_mean, occurrence_variation,
+                polarity_balance, failed_literal_fraction, probe_implied_fraction};
+    }
+
+    static const vector<string>& names() {
+        static const vector<string> feature_names = {"variables", "clauses", "ratio",
+            "unit", "binary", "ternary", "long", "mean_length", "fixed_width",
+            "occurrence_mean", "occurrence_variation", "polarity_balance",
+            "failed_literals", "probe_implied"};
+        return feature_names;
+    }
+};
+
+/* computes InstanceFeatures; keeps its tables between formulas, so extracting
+ * the features of a stream of instances barely allocates
+*/
+class FeatureExtractor
+{
+    int num_variables;
+    // clauses containing literal l are literal_occurrences[occurrence_start[l] .. occurrence_start[l + 1])
+    vector<int> literal_occurrences;
+    vector<int> occurrence_start;
+    vector<int> variable_occurrences;
+    vector<int> polarity_difference;
+    vector<signed char> literal_values;
+    vector<Lit> trail;
+    vector<int> probe_order;
+    long long ticks;
+
+    void assign(Lit literal) {
+        literal_values[literal] = LIT_TRUE;
+        literal_values[negateLiteral(literal)] = LIT_FALSE;
+        trail.push_back(literal);
+    }
+
+    void backtrack(int trail_size) {
+        while (trail.size() > trail_size) {
+            literal_values[trail.back()] = LIT_UNASSIGNED;
+            literal_values[negateLiteral(trail.back())] = LIT_UNASSIGNED;
+            trail.pop_back();
+        }
+    }
+
+    bool propagate(const CNFFormula& formula, int head);
+    void probe(const CNFFormula& formula, InstanceFeatures& features);
+
+public:
+    InstanceFeatures extract(const CNFFormula& formula);
+};
+
+// unit propagation of trail[head ..] by visiting whole clauses; false on a conflict
+inline bool FeatureExtractor::propagate(const CNFFormula& formula, int head) {
+    while (head < trail.size()) {
+        Lit falsified = negateLiteral(trail[head++]);
+        for (int i = occurrence_start[falsified]; i < occurrence_start[falsified + 1]; i++) {
+            int clause = literal_occurrences[i];
+            const Lit* literals = formula.clauseLiterals(clause);
+            int size = formula.clauseSize(clause);
+            ticks += size;
+            int num_unassigned = 0;
+            Lit unassigned = 0;
+            bool is_satisfied = false;
+            for (int k = 0; k < size && !is_satisfied; k++) {
+                if (literal_values[literals[k]] == LIT_TRUE) is_satisfied = true;
+                else if (literal_values[literals[k]] == LIT_UNASSIGNED) {
+                    num_unassigned++;
+                    unassigned = literals[k];
+                }
+            }
+            if (is_satisfied || num_unassigned > 1) continue;
+            if (num_unassigned == 0) return false;
+            assign(unassigned);
+        }
+    }
+    return true;
+}
+
+// probes both polarities of the most frequent variables left free by the unit clauses
+inline void FeatureExtractor::probe(const CNFFormula& formula, InstanceFeatures& features) {
+    for (int c = 0; c < formula.numClauses(); c++) {
+        if (formula.clauseSize(c) == 0) features.has_root_conflict = true;
+        if (formula.clauseSize(c) != 1) continue;
+        Lit literal = formula.clauseLiterals(c)[0];
+        if (literal_values[literal] == LIT_FALSE) features.has_root_conflict = true;
+        else if (literal_values[literal] == LIT_UNASSIGNED) assign(literal);
+    }
+    ticks = 0;
+    if (features.has_root_conflict || !propagate(formula, 0)) {
+        features.has_root_conflict = true;
+        features.failed_literal_fraction = 1;
+        return;
+    }
+
+    probe_order.clear();
+    for (int v = 0; v < num_variables; v++) {
+        if (literal_values[makeLiteral(v, false)] == LIT_UNASSIGNED && variable_occurrences[v] > 0) probe_order.push_back(v);
+    }
+    int num_candidates = min((int) probe_order.size(), FEATURE_PROBE_VARIABLES);
+    partial_sort(probe_order.begin(), probe_order.begin() + num_candidates, probe_order.end(),
+                 [this](int a, int b) { return variable_occurrences[a] > variable_occurrences[b]; });
+
+    long long tick_limit = max(FEATURE_MIN_PROBE_TICKS, FEATURE_PROBE_TICKS_PER_LITERAL * (long long) formula.literals.size());
+    int root_size = trail.size();
+    int num_probes = 0;
+    int num_failed = 0;
+    long long num_implied = 0;
+    for (int i = 0; i < 2 * num_candidates && ticks < tick_limit; i++) {
+        Lit literal = makeLiteral(probe_order[i / 2], i % 2 == 1);
+        assign(literal);
+        if (!propagate(formula, root_size)) num_failed++;
+        num_implied += trail.size() - root_size - 1;
+        num_probes++;
+        backtrack(root_size);
+    }
+    if (num_probes > 0) {
+        features.failed_literal_fraction = (double) num_failed / num_probes;
+        features.probe_implied_fraction = (double) num_implied / num_probes / max(1, num_variables);
+    }
+}
+
+inline InstanceFeatures FeatureExtractor::extract(const CNFFormula& formula) {
+    InstanceFeatures features;
+    num_variables = formula.num_variables;
+    int num_clauses = formula.numClauses();
+    features.num_variables = num_variables;
+    features.num_clauses = num_clauses;
+    features.clause_variable_ratio = (double) num_clauses / max(1, num_variables);
+
+    // clause lengths, occurrences and polarities in one pass
+    variable_occurrences.assign(num_variables, 0);
+    polarity_difference.assign(num_variables, 0);
+    occurrence_start.assign(2 * num_variables + 1, 0);
+    int num_units = 0, num_binaries = 0, num_ternaries = 0;
+    features.fixed_width = num_clauses > 0 ? formula.clauseSize(0) : 0;
+    for (int c = 0; c < num_clauses; c++) {
+        int size = formula.clauseSize(c);
+        num_units += size == 1;
+        num_binaries += size == 2;
+        num_ternaries += size == 3;
+        if (size != features.fixed_width) features.fixed_width = 0;
+        const Lit* literals = formula.clauseLiterals(c);
+        for (int k = 0; k < size; k++) {
+            int variable = literalVariable(literals[k]);
+            variable_occurrences[variable]++;
+            polarity_difference[variable] += isNegativeLiteral(literals[k]) ? -1 : 1;
+            occurrence_start[literals[k]]++;
+        }
+    }
+    if (num_clauses > 0) {
+        features.unit_fraction = (double) num_units / num_clauses;
+        features.binary_fraction = (double) num_binaries / num_clauses;
+        features.ternary_fraction = (double) num_ternaries / num_clauses;
+        features.long_fraction = 1 - features.unit_fraction - features.binary_fraction - features.ternary_fraction;
+        features.mean_clause_length = (double) formula.literals.size() / num_clauses;
+    }
+
+    double occurrence_sum = 0, occurrence_square_sum = 0, balance_sum = 0;
+    int num_occurring = 0;
+    for (int v = 0; v < num_variables; v++) {
+        if (variable_occurrences[v] == 0) continue;
+        num_occurring++;
+        occurrence_sum += variable_occurrences[v];
+        occurrence_square_sum += (double) variable_occurrences[v] * variable_occurrences[v];
+        balance_sum += (double) abs(polarity_difference[v]) / variable_occurrences[v];
+    }
+    if (num_occurring > 0) {
+        features.occurrence_mean = occurrence_sum / num_occurring;
+        double variance = max(0.0, occurrence_square_sum / num_occurring - features.occurrence_mean * features.occurrence_mean);
+        features.occurrence_variation = sqrt(variance) / features.occurrence_mean;
+        features.polarity_balance = balance_sum / num_occurring;
+    }
+
+    // occurrence lists for probing: prefix sums make occurrence_start[l] the end
+    // of l's list, filling back to front moves it to the start
+    for (int l = 1; l <= 2 * num_variables; l++) occurrence_start[l] += occurrence_start[l - 1];
+    literal_occurrences.resize(formula.literals.size());
+    for (int c = num_clauses - 1; c >= 0; c--) {
+        const Lit* literals = formula.clauseLiterals(c);
+        for (int k = 0; k < formula.clauseSize(c); k++) literal_occurrences[--occurrence_start[literals[k]]] = c;
+    }
+
+    literal_values.assign(2 * num_variables, LIT_UNASSIGNED);
+    trail.clear();
+    probe(formula, features);
+    return features;
+}
+
+// picks an engine, by the name createSolver() knows it under, for a formula with these features
+class EngineSelector
+{
+public:
+    virtual ~EngineSelector() {}
+    virtual string select(const InstanceFeatures& features) = 0;
+};
+
+// engines the rules choose from
+const char* const SELECT_SMALL_ENGINE = "frequency-none-polarity";
+const char* const SELECT_RANDOM_ENGINE = "lookahead";
+const char* const SELECT_SATISFIABLE_ENGINE = "probsat+vsids-luby-saved";
+const char* const SELECT_STRUCTURED_ENGINE = "vsids-mode-target";
+// formulas this small are enumerated outright
+const int SELECT_BRUTE_FORCE_VARIABLES = 16;
+// below this many variables the frequency heuristic solves anything in milliseconds
+const int SELECT_SMALL_VARIABLES = 100;
+// lookahead pays off on random formulas up to this size; beyond it CDCL scales better
+const int SELECT_LOOKAHEAD_MAX_VARIABLES = 1000;
+// a random formula is underconstrained, and most likely satisfiable, below this fraction of the threshold ratio
+const double SELECT_UNDERCONSTRAINED_RATIO = 0.9;
+// occurrence counts of uniform random formulas vary about as little as a Poisson distribution's
+const double SELECT_RANDOM_MAX_VARIATION = 0.6;
+
+/* rules read off the test families (40 instances each):
+ * random 3-SAT at the threshold is lookahead's ground (unsat150: 0.6 s against
+ * 1.4 s for frequency and 1.9 s for vsids), local search finds models of
+ * satisfiable ones fast but never proves unsatisfiability, and below 100
+ * variables the frequency heuristic is as fast as anything.
+ * Everything that does not look like uniform random k-SAT goes to CDCL with
+ * focused and stable modes, the most robust configuration on structure.
+*/
+class RuleSelector : public EngineSelector
+{
+    // ratio where random k-SAT turns from satisfiable to unsatisfiable
+    static double thresholdRatio(int width) {
+        static const double thresholds[] = {0, 0, 1, 4.267, 9.931, 21.117, 43.37, 87.79};
+        if (width < 8) return thresholds[width];
+        return pow(2.0, width) * log(2.0) - (1 + log(2.0)) / 2;
+    }
+
+public:
+    string select(const InstanceFeatures& features) {
+        if (features.num_variables <= SELECT_BRUTE_FORCE_VARIABLES) return "bruteforce";
+        bool is_random = features.fixed_width >= 3 && features.occurrence_variation < SELECT_RANDOM_MAX_VARIATION;
+        if (!is_random) {
+            return features.num_variables < SELECT_SMALL_VARIABLES ? SELECT_SMALL_ENGINE : SELECT_STRUCTURED_ENGINE;
+        }
+        if (features.clause_variable_ratio < SELECT_UNDERCONSTRAINED_RATIO * thresholdRatio(features.fixed_width)) {
+            return SELECT_SATISFIABLE_ENGINE;
+        }
+        if (features.num_variables < SELECT_SMALL_VARIABLES) return SELECT_SMALL_ENGINE;
+        if (features.num_variables <= SELECT_LOOKAHEAD_MAX_VARIABLES) return SELECT_RANDOM_ENGINE;
+        return SELECT_STRUCTURED_ENGINE;
+    }
+};
+
+/* answers with the engine of the nearest known instance.
+ * The model file has one instance per line: the engine that solved it best,
+ * then its feature values in the order of InstanceFeatures::names(), as the
+ * "features" mode prints them; lines starting with 'c' or '#' are comments.
+ * Each feature is scaled by its range over the model, so large counts do not
+ * drown out the fractions.
+*/
+class NearestNeighbourSelector : public EngineSelector
+{
+    vector<string> engines;
+    vector<vector<double>> points;
+    vector<double> minimum;
+    vector<double> range;
+
+public:
+    // false (with a message on cerr) if the file cannot be read or has no usable line
+    bool load(const string& path) {
+        ifstream in(path);
+        if (!in) {
+            cerr << "cannot read selector model " << path << endl;
+            return false;
+        }
+        int num_features = InstanceFeatures::names().size();
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == 'c' || line[0] == '#') continue;
+            istringstream fields(line);
+            string engine;
+            vector<double> point(num_features);
+            fields >> engine;
+            int read = 0;
+            while (read < num_features && fields >> point[read]) read++;
+            if (read < num_features) {
+                cerr << "ignoring selector model line: " << line << endl;
+                continue;
+            }
+            engines.push_back(engine);
+            points.push_back(point);
+        }
+        if (points.empty()) {
+            cerr << "no instances in selector model " << path << endl;
+            return false;
+        }
+        minimum = points[0];
+        vector<double> maximum = points[0];
+        for (int p = 1; p < points.size(); p++) {
+            for (int f = 0; f < num_features; f++) {
+                minimum[f] = min(minimum[f], points[p][f]);
+                maximum[f] = max(maximum[f], points[p][f]);
+            }
+        }
+        range.resize(num_features);
+        for (int f = 0; f < num_features; f++) range[f] = maximum[f] > minimum[f] ? maximum[f] - minimum[f] : 1;
+        return true;
+    }
+
+    string select(const InstanceFeatures& features) {
+        vector<double> query = features.values();
+        int nearest = 0;
+        double nearest_distance = INFINITY;
+        for (int p = 0; p < points.size(); p++) {
+            double distance = 0;
+            for (int f = 0; f < query.size(); f++) {
+                double difference = (query[f] - points[p][f]) / range[f];
+                distance += difference * difference;
+            }
+            if (distance < nearest_distance) {
+                nearest_distance = distance;
+                nearest = p;
+            }
+        }
+        return engines[nearest];
+    }
+};
+
+/* the "auto" engine: load() extracts the features, asks the selector for an
+ * engine and hands the formula to it. Engines it has chosen before are kept,
+ * so a stream of similar instances reuses one warm engine.
+*/
+class AutoSelectingSolver : public SatSolver
+{
+public:
+    typedef unique_ptr<SatSolver> (*EngineFactory)(const string& name);
+
+private:
+    unique_ptr<EngineSelector> selector;
+    EngineFactory create_engine;
+    FeatureExtractor extractor;
+    map<string, unique_ptr<SatSolver>> engines;
+    atomic<SatSolver*> active;
+    SolverBudget budget;
+    SolverOptions options;
+    uint64_t random_seed = 0;
+    SolverStatistics no_statistics;
+
+public:
+    InstanceFeatures features;
+    string selected_engine;
+
+    AutoSelectingSolver(unique_ptr<EngineSelector> engine_selector, EngineFactory factory)
+        : selector(move(engine_selector)), create_engine(factory), active(nullptr) {}
+
+    void load(const CNFFormula& formula) {
+        features = extractor.extract(formula);
+        selected_engine = selector->select(features);
+        unique_ptr<SatSolver>& engine = engines[selected_engine];
+        if (!engine) engine = create_engine(selected_engine);
+        if (!engine) {
+            cerr << "selector chose unknown engine " << selected_engine << ", using " << SELECT_STRUCTURED_ENGINE << endl;
+            engines.erase(selected_engine);
+            selected_engine = SELECT_STRUCTURED_ENGINE;
+            unique_ptr<SatSolver>& fallback = engines[selected_engine];
+            if (!fallback) fallback = create_engine(selected_engine);
+            active = fallback.get();
+        } else {
+            active = engine.get();
+        }
+        active.load()->setSeed(random_seed);
+        active.load()->setBudget(budget);
+        active.load()->setOptions(options);
+        active.load()->load(formula);
+    }
+
+    void reset() {
+        if (active) active.load()->reset();
+    }
+
+    ReturnValue search() { return active.load()->search(); }
+    int numVariables() { return active.load()->numVariables(); }
+    bool modelValue(int variable) { return active.load()->modelValue(variable); }
+
+    void suggestPhase(int variable, bool is_negative) {
+        if (active) active.load()->suggestPhase(variable, is_negative);
+    }
+
+    void suggestAssignment(const vector<Lit>& literals) {
+        if (active) active.load()->suggestAssignment(literals);
+    }
+
+    void setBudget(const SolverBudget& new_budget) {
+        budget = new_budget;
+        if (active) active.load()->setBudget(new_budget);
+    }
+
+    void setOptions(const SolverOptions& new_options) {
+        options = new_options;
+        if (active) active.load()->setOptions(new_options);
+    }
+
+    void setSeed(uint64_t seed) { random_seed = seed; }
+
+    void interrupt() {
+        SatSolver* engine = active;
+        if (engine) engine->interrupt();
+    }
+
+    const SolverStatistics& getStatistics() {
+        if (!active) return no_statistics;
+        return active.load()->getStatistics();
+    }
+};
+
+#endif
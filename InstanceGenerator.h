@@ -0,0 +1,246 @@
+#ifndef INSTANCE_GENERATOR_H
+#define INSTANCE_GENERATOR_H
+
+#include <sys/resource.h>
+#include "SolverRegistry.h"
+
+/* Random k-SAT instances of any size, for measuring how the engines scale
+ * past the 150 variables of the bundled families.
+ *
+ * Uniform random k-SAT: each clause takes k distinct variables uniformly at
+ * random and negates each with probability 1/2. Around the threshold ratio
+ * (4.26 for k = 3) these are the hardest random formulas, about half of them
+ * satisfiable.
+ * Planted: a hidden assignment is drawn first, and clauses falsified by it or
+ * by its complement are redrawn ("2-hidden"). The formula is satisfiable at
+ * any ratio, and since the complement is a model too, the literal signs stay
+ * balanced and give the hidden assignment away no more than in a uniform
+ * formula; plain rejection on the assignment alone would skew every
+ * variable's polarity towards it.
+ *
+ * Both are reproducible from (n, k, ratio, seed).
+*/
+
+struct GeneratorParams
+{
+    int num_variables = 100;
+    int width = 3;
+    double ratio = 4.26;
+    bool planted = false;
+    uint64_t seed = 0;
+};
+
+// returns false (with a message on cerr) if the parameters admit no formula
+inline bool generateRandomFormula(const GeneratorParams& params, CNFFormula& formula) {
+    if (params.width < 1 || params.width > params.num_variables || params.ratio < 0) {
+        cerr << "cannot draw " << params.width << "-literal clauses over " << params.num_variables << " variables" << endl;
+        return false;
+    }
+    if (params.planted && params.width < 2) {
+        cerr << "planted formulas need clauses of at least 2 literals" << endl;
+        return false;
+    }
+    Xoshiro256 generator(params.seed);
+    vector<char> hidden_negative(params.num_variables);
+    if (params.planted) {
+        for (int v = 0; v < params.num_variables; v++) hidden_negative[v] = generator.next() >> 63;
+    }
+
+    formula.clear();
+    formula.num_variables = params.num_variables;
+    long long num_clauses = llround(params.ratio * params.num_variables);
+    formula.literals.reserve(num_clauses * params.width);
+    formula.clause_start.reserve(num_clauses + 1);
+    vector<Lit> clause(params.width);
+    for (long long c = 0; c < num_clauses; c++) {
+        while (true) {
+            // k distinct variables; clauses are short, so a linear duplicate check is the fastest
+            for (int k = 0; k < params.width; k++) {
+                int variable;
+                bool is_duplicate;
+                do {
+                    variable = generator.below(params.num_variables);
+                    is_duplicate = false;
+                    for (int j = 0; j < k && !is_duplicate; j++) is_duplicate = literalVariable(clause[j]) == variable;
+                } while (is_duplicate);
+                clause[k] = makeLiteral(variable, generator.next() >> 63);
+            }
+            if (!params.planted) break;
+            // a literal agreeing with the hidden assignment satisfies it, one disagreeing satisfies its complement
+            int num_agreeing = 0;
+            for (int k = 0; k < params.width; k++) {
+                num_agreeing += isNegativeLiteral(clause[k]) == (bool) hidden_negative[literalVariable(clause[k])];
+            }
+            if (num_agreeing > 0 && num_agreeing < params.width) break;
+        }
+        formula.addClause(clause);
+    }
+    return true;
+}
+
+/* "generate N [--width K] [--ratio R] [--seed S] [--planted 0|1]": writes a
+ * random k-SAT formula over N variables to stdout in DIMACS
+*/
+inline int runGenerator(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: generate VARIABLES [--width K] [--ratio R] [--seed S] [--planted 0|1]" << endl;
+        return 1;
+    }
+    GeneratorParams params;
+    params.num_variables = stoi(argv[2]);
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--width") params.width = stoi(argv[i + 1]);
+        else if (option == "--ratio") params.ratio = stod(argv[i + 1]);
+        else if (option == "--seed") params.seed = stoull(argv[i + 1]);
+        else if (option == "--planted") params.planted = stoi(argv[i + 1]) != 0;
+        else cerr << "ignoring unknown option " << option << endl;
+    }
+    CNFFormula formula;
+    if (!generateRandomFormula(params, formula)) return 1;
+    cout << "c " << (params.planted ? "planted" : "uniform") << " random " << params.width << "-SAT, ratio "
+         << params.ratio << ", seed " << params.seed << endl;
+    writeDimacs(cout, formula);
+    return 0;
+}
+
+// settings of a scaling sweep: instances_per_size formulas at each n from min to max
+struct ScalingParams
+{
+    GeneratorParams generator;
+    int min_variables = 100;
+    int max_variables = 400;
+    int variable_step = 50;
+    int instances_per_size = 5;
+    string heuristic = "frequency-none-polarity";
+    SolverBudget budget;
+    SolverOptions options;
+};
+
+// peak resident set size of the whole process so far
+inline double peakResidentMB() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is in kilobytes on Linux
+    return usage.ru_maxrss / 1024.0;
+}
+
+/* solves fresh random formulas at growing n and prints one row per size:
+ * the answers, mean and median seconds (load plus search; unfinished runs
+ * count with the time they used), the growth of the median over the
+ * previous size and its local exponent log(growth) / log(n ratio), which
+ * climbs steadily for exponential scaling and jumps on a regression,
+ * propagations per second, the largest solver memory and the process peak RSS
+*/
+inline void runScalingSweep(const ScalingParams& params, ostream& out) {
+    unique_ptr<SatSolver> solver = createSolver(params.heuristic);
+    solver->setBudget(params.budget);
+    solver->setOptions(params.options);
+    CNFFormula formula;
+    out << "c " << (params.generator.planted ? "planted" : "uniform") << " random " << params.generator.width
+        << "-SAT at ratio " << params.generator.ratio << ", " << params.instances_per_size << " instances per size, "
+        << params.heuristic << endl;
+    out << "c      n    sat  unsat unknown     mean_s   median_s   growth exponent   props/s  solver_MB    peak_MB" << endl;
+
+    double previous_median = -1;
+    int previous_variables = 0;
+    for (int n = params.min_variables; n <= params.max_variables && !interrupt_signalled; n += max(1, params.variable_step)) {
+        int num_sat = 0, num_unsat = 0, num_unknown = 0;
+        long long propagations = 0;
+        double solver_memory = 0;
+        vector<double> seconds;
+        for (int i = 0; i < params.instances_per_size && !interrupt_signalled; i++) {
+            GeneratorParams generator = params.generator;
+            generator.num_variables = n;
+            // every (size, index) pair gets its own formula, the same from run to run
+            generator.seed = params.generator.seed + ((uint64_t) n << 32) + i;
+            if (!generateRandomFormula(generator, formula)) return;
+
+            auto start = chrono::steady_clock::now();
+            solver->setSeed(generator.seed);
+            solver->reset();
+            solver->load(formula);
+            ReturnValue result = solver->search();
+            seconds.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+            const SolverStatistics& statistics = solver->getStatistics();
+            propagations += statistics.propagations;
+            solver_memory = max(solver_memory, statistics.memory_mb);
+            if (result == ReturnValue::sat) {
+                num_sat++;
+                for (int c = 0; c < formula.numClauses(); c++) {
+                    bool is_satisfied = false;
+                    for (int k = 0; k < formula.clauseSize(c) && !is_satisfied; k++) {
+                        Lit literal = formula.clauseLiterals(c)[k];
+                        is_satisfied = solver->modelValue(literalVariable(literal)) != isNegativeLiteral(literal);
+                    }
+                    if (!is_satisfied) {
+                        cerr << "wrong model for n = " << n << ", seed " << generator.seed << endl;
+                        break;
+                    }
+                }
+            } else if (result == ReturnValue::unsat) {
+                num_unsat++;
+                if (params.generator.planted) cerr << "planted formula reported UNSAT for n = " << n << ", seed " << generator.seed << endl;
+            } else {
+                num_unknown++;
+            }
+        }
+        if (seconds.empty()) break;
+
+        double total_seconds = 0;
+        for (int i = 0; i < seconds.size(); i++) total_seconds += seconds[i];
+        sort(seconds.begin(), seconds.end());
+        double median = seconds.size() % 2 ? seconds[seconds.size() / 2]
+                                           : (seconds[seconds.size() / 2 - 1] + seconds[seconds.size() / 2]) / 2;
+        char row[256];
+        int length = snprintf(row, sizeof(row), "%8d %6d %6d %7d %10.4f %10.4f", n, num_sat, num_unsat, num_unknown,
+                              total_seconds / seconds.size(), median);
+        if (previous_median > 0 && median > 0) {
+            double growth = median / previous_median;
+            snprintf(row + length, sizeof(row) - length, " %8.2f %8.2f", growth, log(growth) / log((double) n / previous_variables));
+        } else {
+            snprintf(row + length, sizeof(row) - length, " %8s %8s", "-", "-");
+        }
+        out << row;
+        snprintf(row, sizeof(row), " %9.3g %10.2f %10.1f", propagations / max(total_seconds, 1e-9), solver_memory, peakResidentMB());
+        out << row << endl;
+        previous_median = median;
+        previous_variables = n;
+    }
+}
+
+/* "scale [options]": the scaling benchmark. options: --from N --to N --step N
+ * (variable counts, default 100 to 400 by 50), --instances M (per size),
+ * --width K, --ratio R (default 4.26), --planted 0|1, --seed S,
+ * --heuristic NAME (default the executable's), and the budget and search
+ * options of a single solve (--time caps each instance)
+*/
+inline int runScalingBenchmark(int argc, char* argv[], const string& heuristic) {
+    ScalingParams params;
+    params.heuristic = heuristic;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--from") params.min_variables = stoi(value);
+        else if (option == "--to") params.max_variables = stoi(value);
+        else if (option == "--step") params.variable_step = stoi(value);
+        else if (option == "--instances") params.instances_per_size = stoi(value);
+        else if (option == "--width") params.generator.width = stoi(value);
+        else if (option == "--ratio") params.generator.ratio = stod(value);
+        else if (option == "--planted") params.generator.planted = stoi(value) != 0;
+        else if (option == "--seed") params.generator.seed = stoull(value);
+        else if (option == "--heuristic") params.heuristic = value;
+        else if (!parseSolveOption(option, value, params.budget, params.options)) cerr << "ignoring unknown option " << option << endl;
+    }
+    if (!createSolver(params.heuristic)) {
+        cerr << "unknown heuristic " << params.heuristic << endl;
+        return 1;
+    }
+    // Ctrl-C ends the instance in progress as unknown and stops the sweep after its size
+    signal(SIGINT, handleInterruptSignal);
+    runScalingSweep(params, cout);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,427 @@
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <memory>
+#include "SolverCommon.h"
+
+/* Stochastic local search for satisfiable instances.
+ * Starts from a random assignment and flips one variable of a random
+ * unsatisfied clause at a time, until no clause is unsatisfied.
+ * It can only ever answer SAT; otherwise the result is UNKNOWN.
+ * Of the budgets, flips (--flips, and --propagations since a flip is its unit
+ * of work), time and memory apply; there are no conflicts to count, so a
+ * conflict budget alone never stops it.
+*/
+
+enum LocalSearchMode
+{
+    probsat,  // flip probability proportional to (eps + break)^-cb
+    walksat   // freebie if break is 0, else random with prob noise, else min break
+};
+
+struct LocalSearchParams
+{
+    LocalSearchMode mode = LocalSearchMode::probsat;
+    // restart from a fresh random assignment after this many flips; -1 for 100 * variables
+    long long flips_per_try = -1;
+    // total flip budget over all tries; -1 means unlimited
+    long long max_flips = -1;
+    // probSAT polynomial break constants tuned for 3-SAT
+    double cb = 2.06;
+    double eps = 0.9;
+    // WalkSAT probability of a random walk step
+    double noise = 0.567;
+};
+
+class LocalSearchSolver : public SatSolver
+{
+    int num_variables;
+    int num_clauses;
+
+    // clause i is clause_literals[clause_start[i] .. clause_start[i + 1])
+    vector<Lit> clause_literals;
+    vector<int> clause_start;
+
+    // occurrence lists: clauses containing literal l are
+    // literal_occurrences[occurrence_start[l] .. occurrence_start[l + 1])
+    vector<int> literal_occurrences;
+    vector<int> occurrence_start;
+
+    // current assignment, 1 if variable is true
+    vector<char> variable_values;
+
+    // number of true literals in each clause
+    vector<int> true_count;
+    // xor of the variables whose literal is true in the clause;
+    // when true_count is 1 this is the single satisfying variable
+    vector<int> true_variable_xor;
+
+    // break: clauses that become unsat if the variable flips
+    // make: unsat clauses that become sat if the variable flips
+    vector<int> break_count;
+    vector<int> make_count;
+
+    // unsatisfied clauses, with the index of each clause in the list (-1 if sat)
+    vector<int> unsat_clauses;
+    vector<int> unsat_position;
+
+    // assignment with the fewest unsat clauses seen so far
+    vector<char> best_values;
+    int best_num_unsat;
+
+    // probSAT weight of a variable by its break count
+    vector<double> break_weight;
+    vector<double> candidate_weight;
+
+    bool has_empty_clause;
+    LocalSearchParams params;
+    SolverBudget budget;
+    SolverStatistics statistics;
+    chrono::steady_clock::time_point solve_start_time;
+    atomic<bool> interrupt_requested{false};
+    Xoshiro256 generator;
+
+    void randomizeAssignment();
+    void flip(int variable);
+    int pickProbSATVariable(int clause);
+    int pickWalkSATVariable(int clause);
+    void addUnsat(int clause);
+    void removeUnsat(int clause);
+    bool isBudgetExhausted();
+    double estimateMemoryMB();
+
+public:
+    explicit LocalSearchSolver(const LocalSearchParams& local_search_params = LocalSearchParams())
+        : params(local_search_params) {}
+
+    void load(const CNFFormula& formula);
+    ReturnValue search();
+    int numVariables() { return num_variables; }
+    bool modelValue(int variable) { return best_values[variable]; }
+    void setBudget(const SolverBudget& new_budget) { budget = new_budget; }
+    void setSeed(uint64_t seed) { generator.setSeed(seed); }
+    void interrupt() { interrupt_requested.store(true, memory_order_relaxed); }
+    const SolverStatistics& getStatistics() { return statistics; }
+    void setParams(const LocalSearchParams& new_params) { params = new_params; }
+
+    // number of clauses the best assignment leaves unsatisfied
+    int bestNumUnsat() { return best_num_unsat; }
+};
+
+inline void LocalSearchSolver::load(const CNFFormula& formula) {
+    num_variables = formula.num_variables;
+    has_empty_clause = false;
+
+    // copy clauses without repeated literals; tautologies are always sat and are dropped
+    clause_literals.clear();
+    clause_start.assign(1, 0);
+    vector<Lit> clause;
+    for (int c = 0; c < formula.numClauses(); c++) {
+        clause.assign(formula.clauseLiterals(c), formula.clauseLiterals(c) + formula.clauseSize(c));
+        sort(clause.begin(), clause.end());
+        clause.erase(unique(clause.begin(), clause.end()), clause.end());
+        bool is_tautology = false;
+        for (int k = 0; k + 1 < clause.size(); k++) {
+            if (clause[k + 1] == negateLiteral(clause[k])) is_tautology = true;
+        }
+        if (is_tautology) continue;
+        clause_literals.insert(clause_literals.end(), clause.begin(), clause.end());
+        clause_start.push_back(clause_literals.size());
+    }
+    num_clauses = clause_start.size() - 1;
+
+    // build occurrence lists by counting, then filling
+    occurrence_start.assign(2 * num_variables + 1, 0);
+    for (int i = 0; i < clause_literals.size(); i++) {
+        occurrence_start[clause_literals[i] + 1]++;
+    }
+    for (int l = 0; l < 2 * num_variables; l++) {
+        occurrence_start[l + 1] += occurrence_start[l];
+    }
+    literal_occurrences.resize(clause_literals.size());
+    vector<int> fill_position(occurrence_start.begin(), occurrence_start.end() - 1);
+    int max_clause_size = 0;
+    for (int c = 0; c < num_clauses; c++) {
+        if (clause_start[c + 1] == clause_start[c]) has_empty_clause = true;
+        max_clause_size = max(max_clause_size, clause_start[c + 1] - clause_start[c]);
+        for (int k = clause_start[c]; k < clause_start[c + 1]; k++) {
+            literal_occurrences[fill_position[clause_literals[k]]++] = c;
+        }
+    }
+
+    variable_values.assign(num_variables, 0);
+    best_values.assign(num_variables, 0);
+    true_count.assign(num_clauses, 0);
+    true_variable_xor.assign(num_clauses, 0);
+    break_count.assign(num_variables, 0);
+    make_count.assign(num_variables, 0);
+    unsat_clauses.clear();
+    unsat_position.assign(num_clauses, -1);
+    candidate_weight.resize(max_clause_size);
+    best_num_unsat = num_clauses + 1;
+
+    // break counts are bounded by the number of occurrences of a literal
+    int max_occurrences = 0;
+    for (int l = 0; l < 2 * num_variables; l++) {
+        max_occurrences = max(max_occurrences, occurrence_start[l + 1] - occurrence_start[l]);
+    }
+    break_weight.resize(max_occurrences + 1);
+    for (int b = 0; b <= max_occurrences; b++) {
+        break_weight[b] = pow(params.eps + b, -params.cb);
+    }
+}
+
+inline void LocalSearchSolver::addUnsat(int clause) {
+    unsat_position[clause] = unsat_clauses.size();
+    unsat_clauses.push_back(clause);
+}
+
+inline void LocalSearchSolver::removeUnsat(int clause) {
+    int position = unsat_position[clause];
+    int last_clause = unsat_clauses.back();
+    unsat_clauses[position] = last_clause;
+    unsat_position[last_clause] = position;
+    unsat_clauses.pop_back();
+    unsat_position[clause] = -1;
+}
+
+// draw a fresh random assignment and rebuild every counter from scratch
+inline void LocalSearchSolver::randomizeAssignment() {
+    for (int v = 0; v < num_variables; v++) {
+        variable_values[v] = generator.next() & 1;
+    }
+    fill(break_count.begin(), break_count.end(), 0);
+    fill(make_count.begin(), make_count.end(), 0);
+    for (int i = 0; i < unsat_clauses.size(); i++) unsat_position[unsat_clauses[i]] = -1;
+    unsat_clauses.clear();
+
+    for (int c = 0; c < num_clauses; c++) {
+        true_count[c] = 0;
+        true_variable_xor[c] = 0;
+        for (int k = clause_start[c]; k < clause_start[c + 1]; k++) {
+            int variable = literalVariable(clause_literals[k]);
+            if (variable_values[variable] != isNegativeLiteral(clause_literals[k])) {
+                true_count[c]++;
+                true_variable_xor[c] ^= variable;
+            }
+        }
+        if (true_count[c] == 0) {
+            addUnsat(c);
+            for (int k = clause_start[c]; k < clause_start[c + 1]; k++) {
+                make_count[literalVariable(clause_literals[k])]++;
+            }
+        } else if (true_count[c] == 1) {
+            break_count[true_variable_xor[c]]++;
+        }
+    }
+}
+
+// flip a variable and update true counts, break/make counters and the unsat list
+inline void LocalSearchSolver::flip(int variable) {
+    variable_values[variable] ^= 1;
+    Lit true_literal = makeLiteral(variable, !variable_values[variable]);
+    Lit false_literal = negateLiteral(true_literal);
+
+    for (int k = occurrence_start[true_literal]; k < occurrence_start[true_literal + 1]; k++) {
+        int c = literal_occurrences[k];
+        int old_count = true_count[c]++;
+        if (old_count == 0) {
+            // clause becomes sat with variable as its only true literal
+            removeUnsat(c);
+            for (int j = clause_start[c]; j < clause_start[c + 1]; j++) {
+                make_count[literalVariable(clause_literals[j])]--;
+            }
+            break_count[variable]++;
+        } else if (old_count == 1) {
+            // the previous single true literal is no longer critical
+            break_count[true_variable_xor[c]]--;
+        }
+        true_variable_xor[c] ^= variable;
+    }
+
+    for (int k = occurrence_start[false_literal]; k < occurrence_start[false_literal + 1]; k++) {
+        int c = literal_occurrences[k];
+        int new_count = --true_count[c];
+        true_variable_xor[c] ^= variable;
+        if (new_count == 0) {
+            // variable was the only true literal: clause becomes unsat
+            addUnsat(c);
+            for (int j = clause_start[c]; j < clause_start[c + 1]; j++) {
+                make_count[literalVariable(clause_literals[j])]++;
+            }
+            break_count[variable]--;
+        } else if (new_count == 1) {
+            // the remaining true literal becomes critical
+            break_count[true_variable_xor[c]]++;
+        }
+    }
+    statistics.flips++;
+}
+
+// probSAT: pick a variable of the clause with probability proportional to break_weight[break]
+inline int LocalSearchSolver::pickProbSATVariable(int clause) {
+    int size = clause_start[clause + 1] - clause_start[clause];
+    const Lit* literals = &clause_literals[clause_start[clause]];
+    double total_weight = 0;
+    for (int k = 0; k < size; k++) {
+        candidate_weight[k] = break_weight[break_count[literalVariable(literals[k])]];
+        total_weight += candidate_weight[k];
+    }
+    double threshold = generator.nextDouble() * total_weight;
+    for (int k = 0; k < size - 1; k++) {
+        threshold -= candidate_weight[k];
+        if (threshold < 0) return literalVariable(literals[k]);
+    }
+    return literalVariable(literals[size - 1]);
+}
+
+// WalkSAT/SKC: a zero-break variable if there is one, else a random or a minimum-break variable
+inline int LocalSearchSolver::pickWalkSATVariable(int clause) {
+    int size = clause_start[clause + 1] - clause_start[clause];
+    const Lit* literals = &clause_literals[clause_start[clause]];
+    int best_variable = literalVariable(literals[0]);
+    int best_break = INT_MAX;
+    int num_ties = 0;
+    for (int k = 0; k < size; k++) {
+        int variable = literalVariable(literals[k]);
+        int b = break_count[variable];
+        if (b < best_break) {
+            best_break = b;
+            best_variable = variable;
+            num_ties = 1;
+        } else if (b == best_break && generator.below(++num_ties) == 0) {
+            // reservoir sampling among equally good variables
+            best_variable = variable;
+        }
+    }
+    if (best_break == 0) return best_variable;
+    if (generator.nextDouble() < params.noise) {
+        return literalVariable(literals[generator.below(size)]);
+    }
+    return best_variable;
+}
+
+// checked every 1024 flips, so a flip budget may be overrun by up to that many
+inline bool LocalSearchSolver::isBudgetExhausted() {
+    if (interrupt_signalled || interrupt_requested.load(memory_order_relaxed)) return true;
+    if (params.max_flips >= 0 && statistics.flips >= params.max_flips) return true;
+    if (budget.max_flips >= 0 && statistics.flips >= budget.max_flips) return true;
+    if (budget.max_propagations >= 0 && statistics.flips >= budget.max_propagations) return true;
+    // memory is all allocated by load(), so search() measured it up front
+    if (budget.max_memory_mb >= 0 && statistics.memory_mb >= budget.max_memory_mb) return true;
+    if (budget.max_seconds >= 0) {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+        if (elapsed.count() >= budget.max_seconds) return true;
+    }
+    return false;
+}
+
+inline ReturnValue LocalSearchSolver::search() {
+    statistics = SolverStatistics();
+    interrupt_requested.store(false, memory_order_relaxed);
+    solve_start_time = chrono::steady_clock::now();
+    statistics.memory_mb = estimateMemoryMB();
+    ReturnValue result = ReturnValue::unknown;
+
+    if (has_empty_clause) {
+        // an empty clause is never satisfied, but only CDCL may claim UNSAT
+        best_num_unsat = 1;
+    } else {
+        long long flips_per_try = params.flips_per_try;
+        if (flips_per_try < 0) flips_per_try = max(100LL * num_variables, 10000LL);
+
+        while (result == ReturnValue::unknown && !isBudgetExhausted()) {
+            // new try from a random assignment
+            randomizeAssignment();
+            for (long long flips = 0; flips < flips_per_try; flips++) {
+                if (unsat_clauses.size() < best_num_unsat) {
+                    best_num_unsat = unsat_clauses.size();
+                    best_values = variable_values;
+                }
+                if (unsat_clauses.empty()) {
+                    result = ReturnValue::sat;
+                    break;
+                }
+                // checking the clock every flip would cost more than the flip
+                if ((flips & 1023) == 0 && isBudgetExhausted()) break;
+
+                int clause = unsat_clauses[generator.below(unsat_clauses.size())];
+                int variable = (params.mode == LocalSearchMode::probsat)
+                    ? pickProbSATVariable(clause) : pickWalkSATVariable(clause);
+                flip(variable);
+            }
+        }
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+    statistics.seconds = elapsed.count();
+    return result;
+}
+
+inline double LocalSearchSolver::estimateMemoryMB() {
+    return (clause_literals.capacity() + literal_occurrences.capacity()
+        + 6.0 * num_clauses + 4.0 * num_variables) * sizeof(int) / (1024.0 * 1024.0);
+}
+
+/* runs local search first and, if it does not find a model within its flip
+ * budget, hands the best assignment it saw to a CDCL solver as saved phases
+ * and lets CDCL finish the job.
+*/
+class PhaseInitializedSolver : public SatSolver
+{
+    LocalSearchSolver local_search;
+    unique_ptr<SatSolver> complete_solver;
+    bool found_by_local_search;
+
+public:
+    PhaseInitializedSolver(const LocalSearchParams& params, unique_ptr<SatSolver> cdcl_solver)
+        : local_search(params), complete_solver(move(cdcl_solver)), found_by_local_search(false) {}
+
+    void load(const CNFFormula& formula) {
+        local_search.load(formula);
+        complete_solver->load(formula);
+    }
+
+    void reset() { complete_solver->reset(); }
+
+    // the hints reach CDCL only: local search starts from its own random assignment
+    void suggestAssignment(const vector<Lit>& literals) { complete_solver->suggestAssignment(literals); }
+
+    ReturnValue search() {
+        found_by_local_search = local_search.search() == ReturnValue::sat;
+        if (found_by_local_search) return ReturnValue::sat;
+        for (int v = 0; v < local_search.numVariables(); v++) {
+            complete_solver->suggestPhase(v, !local_search.modelValue(v));
+        }
+        return complete_solver->search();
+    }
+
+    int numVariables() { return complete_solver->numVariables(); }
+
+    bool modelValue(int variable) {
+        return found_by_local_search ? local_search.modelValue(variable) : complete_solver->modelValue(variable);
+    }
+
+    void setBudget(const SolverBudget& new_budget) {
+        local_search.setBudget(new_budget);
+        complete_solver->setBudget(new_budget);
+    }
+
+    void setOptions(const SolverOptions& new_options) { complete_solver->setOptions(new_options); }
+
+    void setSeed(uint64_t seed) {
+        local_search.setSeed(seed);
+        complete_solver->setSeed(seed);
+    }
+
+    void interrupt() {
+        local_search.interrupt();
+        complete_solver->interrupt();
+    }
+
+    const SolverStatistics& getStatistics() {
+        return found_by_local_search ? local_search.getStatistics() : complete_solver->getStatistics();
+    }
+};
+
+#endif
@@ -0,0 +1,524 @@
+#ifndef LOOKAHEAD_SOLVER_H
+#define LOOKAHEAD_SOLVER_H
+
+#include "SolverCommon.h"
+
+/* march-style lookahead DPLL, aimed at small hard random k-SAT.
+ * No clauses are learned; instead every node of the search tree spends its
+ * effort on picking a good branch:
+ *  - preselection ranks the free variables by their occurrences in the
+ *    reduced clauses and keeps the best few as candidates
+ *  - each polarity of each candidate is tentatively assigned and propagated;
+ *    a polarity that leads to a conflict is a failed literal, so its negation
+ *    is forced at the node
+ *  - a literal implied by both polarities of a candidate is forced as well
+ *  - the candidate whose polarities shrink the most clauses, weighted by the
+ *    size they shrink to (weighted binary reduction), becomes the branch
+ * Implications found through clauses of 3+ literals while looking ahead are
+ * kept in a local learning table as binary clauses, valid below the node
+ * they were found at, so their contrapositive also propagates.
+ *
+ * Assignments are propagated with per-clause counters of true and false
+ * literals, which also tell the lookahead how much each clause was reduced.
+*/
+
+// lookahead on at least this many candidates per node, if there are that many free variables
+const int LOOKAHEAD_MIN_CANDIDATES = 10;
+// fraction of the free variables preselected for lookahead
+const double LOOKAHEAD_CANDIDATE_FRACTION = 0.1;
+
+class LookaheadSolver : public SatSolver
+{
+    int num_variables;
+    int num_clauses;
+
+    // clause i is clause_literals[clause_start[i] .. clause_start[i + 1])
+    vector<Lit> clause_literals;
+    vector<int> clause_start;
+
+    // clauses containing literal l are literal_occurrences[occurrence_start[l] .. occurrence_start[l + 1])
+    vector<int> literal_occurrences;
+    vector<int> occurrence_start;
+
+    vector<signed char> literal_values;
+
+    // number of true and false literals in each clause, counting processed trail literals only
+    vector<int> clause_true_count;
+    vector<int> clause_false_count;
+
+    // assigned literals in assignment order; trail[0 .. propagation_head) have updated the counters
+    vector<Lit> trail;
+    int propagation_head;
+
+    // one entry per decision level: the literal currently assigned for it and whether it is the second branch
+    vector<Lit> decision_literals;
+    vector<char> decision_flipped;
+    // trail size and local learning stack size when each decision was made
+    vector<int> decision_trail_start;
+    vector<int> decision_local_start;
+
+    /* local learning table: local_implications[l] are literals implied by l
+     * under the current node's assignments. Entries are appended in order and
+     * local_learned_literals records whose list grew, so undoing a level pops
+     * them back off.
+    */
+    vector<vector<Lit>> local_implications;
+    vector<Lit> local_learned_literals;
+
+    // weight of a clause reduced to k free literals; binary clauses count most
+    vector<double> reduction_weight;
+
+    // lookahead scratch: stamps of literals implied by the positive polarity of the current candidate
+    vector<int> implied_stamp;
+    int current_stamp;
+    // literals forced through clauses of 3+ literals during the current lookahead
+    vector<Lit> long_implications;
+    bool recording_lookahead;
+    double lookahead_reduction;
+
+    vector<double> preselection_score;
+    vector<int> candidates;
+
+    bool has_empty_clause;
+    vector<char> model;
+    SolverBudget budget;
+    SolverStatistics statistics;
+    chrono::steady_clock::time_point solve_start_time;
+    atomic<bool> interrupt_requested{false};
+
+    void assign(Lit literal);
+    bool propagate();
+    void undoTo(int trail_size);
+    void popDecision();
+    bool backtrackAfterConflict();
+    void addLocalImplication(Lit from, Lit to);
+    void preselectCandidates();
+    int lookahead(Lit& branch_literal);
+    ReturnValue runLookahead(int cube_depth, vector<vector<Lit>>* cubes);
+    bool isBudgetExhausted();
+    double estimateMemoryMB();
+
+public:
+    void load(const CNFFormula& formula);
+    ReturnValue search();
+    int numVariables() { return num_variables; }
+    bool modelValue(int variable) { return model[variable]; }
+    void setBudget(const SolverBudget& new_budget) { budget = new_budget; }
+    void setSeed(uint64_t seed) {}
+    void interrupt() { interrupt_requested.store(true, memory_order_relaxed); }
+    const SolverStatistics& getStatistics() { return statistics; }
+
+    /* splits the formula into cubes: the lookahead tree is explored down to
+     * cube_depth decisions and each open leaf becomes a cube, given as its
+     * decision literals. Refuted branches produce no cube. Returns unsat if
+     * every branch was refuted, sat if a leaf above that depth already
+     * satisfies the formula (that leaf is still emitted), unknown otherwise.
+    */
+    ReturnValue generateCubes(int cube_depth, vector<vector<Lit>>& cubes);
+};
+
+inline void LookaheadSolver::load(const CNFFormula& formula) {
+    num_variables = formula.num_variables;
+    has_empty_clause = false;
+
+    // copy clauses without repeated literals; tautologies are always sat and are dropped
+    clause_literals.clear();
+    clause_start.assign(1, 0);
+    vector<Lit> clause;
+    for (int c = 0; c < formula.numClauses(); c++) {
+        clause.assign(formula.clauseLiterals(c), formula.clauseLiterals(c) + formula.clauseSize(c));
+        sort(clause.begin(), clause.end());
+        clause.erase(unique(clause.begin(), clause.end()), clause.end());
+        bool is_tautology = false;
+        for (int k = 0; k + 1 < clause.size(); k++) {
+            if (clause[k + 1] == negateLiteral(clause[k])) is_tautology = true;
+        }
+        if (is_tautology) continue;
+        if (clause.empty()) has_empty_clause = true;
+        clause_literals.insert(clause_literals.end(), clause.begin(), clause.end());
+        clause_start.push_back(clause_literals.size());
+    }
+    num_clauses = clause_start.size() - 1;
+
+    // build occurrence lists by counting, then filling
+    occurrence_start.assign(2 * num_variables + 1, 0);
+    for (int i = 0; i < clause_literals.size(); i++) {
+        occurrence_start[clause_literals[i] + 1]++;
+    }
+    for (int l = 0; l < 2 * num_variables; l++) {
+        occurrence_start[l + 1] += occurrence_start[l];
+    }
+    literal_occurrences.resize(clause_literals.size());
+    vector<int> fill_position(occurrence_start.begin(), occurrence_start.end() - 1);
+    int max_clause_size = 0;
+    for (int c = 0; c < num_clauses; c++) {
+        max_clause_size = max(max_clause_size, clause_start[c + 1] - clause_start[c]);
+        for (int k = clause_start[c]; k < clause_start[c + 1]; k++) {
+            literal_occurrences[fill_position[clause_literals[k]]++] = c;
+        }
+    }
+
+    // a clause reduced to k literals weighs 5^(2 - k): 1 for binaries, 0.2 for ternaries, ...
+    reduction_weight.assign(max(max_clause_size, 2) + 1, 0);
+    for (int k = 2; k < reduction_weight.size(); k++) {
+        reduction_weight[k] = pow(5.0, 2 - k);
+    }
+
+    literal_values.assign(2 * num_variables, LIT_UNASSIGNED);
+    clause_true_count.assign(num_clauses, 0);
+    clause_false_count.assign(num_clauses, 0);
+    trail.clear();
+    trail.reserve(num_variables);
+    propagation_head = 0;
+    decision_literals.clear();
+    decision_flipped.clear();
+    decision_trail_start.clear();
+    decision_local_start.clear();
+    local_implications.assign(2 * num_variables, vector<Lit>());
+    local_learned_literals.clear();
+    implied_stamp.assign(2 * num_variables, 0);
+    current_stamp = 0;
+    recording_lookahead = false;
+    preselection_score.assign(2 * num_variables, 0);
+    model.assign(num_variables, 0);
+}
+
+inline void LookaheadSolver::assign(Lit literal) {
+    literal_values[literal] = LIT_TRUE;
+    literal_values[negateLiteral(literal)] = LIT_FALSE;
+    trail.push_back(literal);
+    statistics.propagations++;
+}
+
+/* processes the trail from propagation_head, updating the clause counters and
+ * assigning unit literals. A literal is always processed completely, even after
+ * a conflict, so undoTo can reverse the counters literal by literal.
+ * Returns false on conflict.
+*/
+inline bool LookaheadSolver::propagate() {
+    bool no_conflict = true;
+    while (no_conflict && propagation_head < trail.size()) {
+        Lit literal = trail[propagation_head++];
+        for (int k = occurrence_start[literal]; k < occurrence_start[literal + 1]; k++) {
+            clause_true_count[literal_occurrences[k]]++;
+        }
+
+        Lit false_literal = negateLiteral(literal);
+        for (int k = occurrence_start[false_literal]; k < occurrence_start[false_literal + 1]; k++) {
+            int c = literal_occurrences[k];
+            int num_false = ++clause_false_count[c];
+            if (clause_true_count[c] > 0 || !no_conflict) continue;
+            int size = clause_start[c + 1] - clause_start[c];
+            int num_free = size - num_false;
+            if (num_free >= 2) {
+                if (recording_lookahead) lookahead_reduction += reduction_weight[num_free];
+                continue;
+            }
+            // the counters lag behind the assignment, so look at the actual values
+            Lit unit = 0;
+            int num_unassigned = 0;
+            bool satisfied = false;
+            for (int j = clause_start[c]; j < clause_start[c + 1]; j++) {
+                signed char value = literal_values[clause_literals[j]];
+                if (value == LIT_TRUE) {
+                    satisfied = true;
+                    break;
+                }
+                if (value == LIT_UNASSIGNED) {
+                    unit = clause_literals[j];
+                    num_unassigned++;
+                }
+            }
+            if (satisfied || num_unassigned > 1) continue;
+            if (num_unassigned == 0) {
+                no_conflict = false;
+                continue;
+            }
+            assign(unit);
+            if (recording_lookahead && size >= 3) long_implications.push_back(unit);
+        }
+
+        // locally learned binary clauses
+        const vector<Lit>& implications = local_implications[literal];
+        for (int k = 0; k < implications.size() && no_conflict; k++) {
+            signed char value = literal_values[implications[k]];
+            if (value == LIT_FALSE) no_conflict = false;
+            else if (value == LIT_UNASSIGNED) assign(implications[k]);
+        }
+    }
+    return no_conflict;
+}
+
+// unassigns the trail back to trail_size literals, reversing the counters of processed ones
+inline void LookaheadSolver::undoTo(int trail_size) {
+    for (int i = trail.size() - 1; i >= trail_size; i--) {
+        Lit literal = trail[i];
+        if (i < propagation_head) {
+            for (int k = occurrence_start[literal]; k < occurrence_start[literal + 1]; k++) {
+                clause_true_count[literal_occurrences[k]]--;
+            }
+            Lit false_literal = negateLiteral(literal);
+            for (int k = occurrence_start[false_literal]; k < occurrence_start[false_literal + 1]; k++) {
+                clause_false_count[literal_occurrences[k]]--;
+            }
+        }
+        literal_values[literal] = LIT_UNASSIGNED;
+        literal_values[negateLiteral(literal)] = LIT_UNASSIGNED;
+    }
+    trail.resize(trail_size);
+    propagation_head = min(propagation_head, trail_size);
+}
+
+// undo the deepest decision level: its assignments and what was learned locally below it
+inline void LookaheadSolver::popDecision() {
+    undoTo(decision_trail_start.back());
+    while (local_learned_literals.size() > decision_local_start.back()) {
+        local_implications[local_learned_literals.back()].pop_back();
+        local_learned_literals.pop_back();
+    }
+}
+
+/* chronological backtracking: undo decisions until one whose second branch
+ * has not been tried, then assign that branch and propagate.
+ * Returns false when no decision is left, i.e. the formula is unsat.
+*/
+inline bool LookaheadSolver::backtrackAfterConflict() {
+    while (!decision_literals.empty()) {
+        popDecision();
+        if (decision_flipped.back()) {
+            decision_literals.pop_back();
+            decision_flipped.pop_back();
+            decision_trail_start.pop_back();
+            decision_local_start.pop_back();
+            continue;
+        }
+        decision_flipped.back() = true;
+        decision_literals.back() = negateLiteral(decision_literals.back());
+        assign(decision_literals.back());
+        if (propagate()) return true;
+        statistics.conflicts++;
+    }
+    return false;
+}
+
+inline void LookaheadSolver::addLocalImplication(Lit from, Lit to) {
+    vector<Lit>& implications = local_implications[from];
+    if (find(implications.begin(), implications.end(), to) != implications.end()) return;
+    implications.push_back(to);
+    local_learned_literals.push_back(from);
+}
+
+// keep the free variables that look most constrained in the reduced formula
+inline void LookaheadSolver::preselectCandidates() {
+    fill(preselection_score.begin(), preselection_score.end(), 0);
+    for (int c = 0; c < num_clauses; c++) {
+        if (clause_true_count[c] > 0) continue;
+        int num_free = clause_start[c + 1] - clause_start[c] - clause_false_count[c];
+        for (int k = clause_start[c]; k < clause_start[c + 1]; k++) {
+            if (literal_values[clause_literals[k]] == LIT_UNASSIGNED) {
+                preselection_score[clause_literals[k]] += reduction_weight[num_free];
+            }
+        }
+    }
+
+    candidates.clear();
+    for (int v = 0; v < num_variables; v++) {
+        Lit positive = makeLiteral(v, false);
+        if (literal_values[positive] != LIT_UNASSIGNED) continue;
+        if (preselection_score[positive] + preselection_score[negateLiteral(positive)] > 0) candidates.push_back(v);
+    }
+
+    // same product as the final lookahead score, on occurrence estimates
+    int num_candidates = max(LOOKAHEAD_MIN_CANDIDATES, (int) (candidates.size() * LOOKAHEAD_CANDIDATE_FRACTION));
+    if (num_candidates >= candidates.size()) return;
+    const vector<double>& score = preselection_score;
+    nth_element(candidates.begin(), candidates.begin() + num_candidates, candidates.end(), [&score](int a, int b) {
+        double positive_a = score[makeLiteral(a, false)], negative_a = score[makeLiteral(a, true)];
+        double positive_b = score[makeLiteral(b, false)], negative_b = score[makeLiteral(b, true)];
+        return 1024 * positive_a * negative_a + positive_a + negative_a
+            > 1024 * positive_b * negative_b + positive_b + negative_b;
+    });
+    candidates.resize(num_candidates);
+}
+
+/* lookahead on the current node, forcing failed literals and necessary
+ * assignments until none are found. Returns 0 and sets branch_literal if
+ * the search has to branch, 1 if every clause is satisfied, -1 on conflict.
+*/
+inline int LookaheadSolver::lookahead(Lit& branch_literal) {
+    bool found_assignment = true;
+    while (found_assignment) {
+        found_assignment = false;
+        preselectCandidates();
+        if (candidates.empty()) return 1;
+
+        double best_score = -1;
+        vector<Lit> necessary;
+        for (int i = 0; i < candidates.size(); i++) {
+            int variable = candidates[i];
+            if (literal_values[makeLiteral(variable, false)] != LIT_UNASSIGNED) continue;
+            current_stamp++;
+            double reduction[2];
+            bool failed = false;
+            necessary.clear();
+            for (int polarity = 0; polarity < 2 && !failed; polarity++) {
+                Lit literal = makeLiteral(variable, polarity == 1);
+                int trail_size = trail.size();
+                recording_lookahead = true;
+                lookahead_reduction = 0;
+                long_implications.clear();
+                assign(literal);
+                bool no_conflict = propagate();
+                recording_lookahead = false;
+                reduction[polarity] = lookahead_reduction;
+
+                if (no_conflict) {
+                    for (int k = trail_size + 1; k < trail.size(); k++) {
+                        if (polarity == 0) implied_stamp[trail[k]] = current_stamp;
+                        else if (implied_stamp[trail[k]] == current_stamp) necessary.push_back(trail[k]);
+                    }
+                    // literal -> m found through a long clause: learn the contrapositive -m -> -literal
+                    for (int k = 0; k < long_implications.size(); k++) {
+                        addLocalImplication(negateLiteral(long_implications[k]), negateLiteral(literal));
+                    }
+                }
+                undoTo(trail_size);
+
+                if (!no_conflict) {
+                    // failed literal: its negation holds at this node
+                    statistics.conflicts++;
+                    failed = true;
+                    found_assignment = true;
+                    assign(negateLiteral(literal));
+                    if (!propagate()) return -1;
+                }
+            }
+            if (failed) continue;
+
+            // implied by both polarities
+            for (int k = 0; k < necessary.size(); k++) {
+                if (literal_values[necessary[k]] != LIT_UNASSIGNED) continue;
+                found_assignment = true;
+                assign(necessary[k]);
+            }
+            if (!propagate()) return -1;
+
+            double score = 1024 * reduction[0] * reduction[1] + reduction[0] + reduction[1];
+            if (score > best_score) {
+                best_score = score;
+                // the side that reduces less is more likely to be satisfiable, so try it first
+                branch_literal = makeLiteral(variable, reduction[0] > reduction[1]);
+            }
+        }
+        if (found_assignment) continue;
+        if (best_score < 0) return 1;
+    }
+    return 0;
+}
+
+inline bool LookaheadSolver::isBudgetExhausted() {
+    if (interrupt_signalled || interrupt_requested.load(memory_order_relaxed)) return true;
+    if (budget.max_conflicts >= 0 && statistics.conflicts >= budget.max_conflicts) return true;
+    if (budget.max_propagations >= 0 && statistics.propagations >= budget.max_propagations) return true;
+    if (budget.max_seconds >= 0) {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+        if (elapsed.count() >= budget.max_seconds) return true;
+    }
+    if (budget.max_memory_mb >= 0 && estimateMemoryMB() >= budget.max_memory_mb) return true;
+    return false;
+}
+
+inline double LookaheadSolver::estimateMemoryMB() {
+    double bytes = (clause_literals.capacity() + literal_occurrences.capacity() + 3.0 * num_clauses
+        + local_learned_literals.capacity() * 2.0 + 6.0 * num_variables) * sizeof(int);
+    return bytes / (1024.0 * 1024.0);
+}
+
+/* the DPLL loop shared by search and generateCubes; with cubes set, nodes
+ * at cube_depth are recorded as cubes and then treated like refuted ones
+*/
+inline ReturnValue LookaheadSolver::runLookahead(int cube_depth, vector<vector<Lit>>* cubes) {
+    if (has_empty_clause) return ReturnValue::unsat;
+    ReturnValue result = ReturnValue::unsat;
+
+    // start over from the root if an earlier call left assignments behind
+    while (!decision_literals.empty()) {
+        popDecision();
+        decision_literals.pop_back();
+        decision_flipped.pop_back();
+        decision_trail_start.pop_back();
+        decision_local_start.pop_back();
+    }
+    undoTo(0);
+
+    // input units are ordinary clauses of size 1; propagate picks them up at level 0
+    for (int c = 0; c < num_clauses; c++) {
+        if (clause_start[c + 1] - clause_start[c] != 1) continue;
+        Lit unit = clause_literals[clause_start[c]];
+        if (literal_values[unit] == LIT_FALSE) return ReturnValue::unsat;
+        if (literal_values[unit] == LIT_UNASSIGNED) assign(unit);
+    }
+    bool no_conflict = propagate();
+
+    while (true) {
+        if (isBudgetExhausted()) return ReturnValue::unknown;
+        Lit branch_literal = 0;
+        int status = no_conflict ? 0 : -1;
+        if (no_conflict && cubes != nullptr && decision_literals.size() >= cube_depth) {
+            cubes->push_back(decision_literals);
+            result = ReturnValue::unknown;
+            status = -1;
+        } else if (no_conflict) {
+            status = lookahead(branch_literal);
+        }
+
+        if (status == 1) {
+            if (cubes == nullptr) {
+                for (int v = 0; v < num_variables; v++) {
+                    model[v] = literal_values[makeLiteral(v, false)] == LIT_TRUE;
+                }
+                return ReturnValue::sat;
+            }
+            cubes->push_back(decision_literals);
+            return ReturnValue::sat;
+        }
+
+        if (status == -1) {
+            if (cubes == nullptr || decision_literals.size() < cube_depth) statistics.conflicts++;
+            if (!backtrackAfterConflict()) return result;
+            no_conflict = true;
+            continue;
+        }
+
+        statistics.decisions++;
+        decision_literals.push_back(branch_literal);
+        decision_flipped.push_back(false);
+        decision_trail_start.push_back(trail.size());
+        decision_local_start.push_back(local_learned_literals.size());
+        assign(branch_literal);
+        no_conflict = propagate();
+    }
+}
+
+inline ReturnValue LookaheadSolver::search() {
+    statistics = SolverStatistics();
+    interrupt_requested.store(false, memory_order_relaxed);
+    solve_start_time = chrono::steady_clock::now();
+
+    ReturnValue result = runLookahead(0, nullptr);
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - solve_start_time;
+    statistics.seconds = elapsed.count();
+    statistics.memory_mb = estimateMemoryMB();
+    return result;
+}
+
+inline ReturnValue LookaheadSolver::generateCubes(int cube_depth, vector<vector<Lit>>& cubes) {
+    statistics = SolverStatistics();
+    interrupt_requested.store(false, memory_order_relaxed);
+    solve_start_time = chrono::steady_clock::now();
+    cubes.clear();
+    return runLookahead(cube_depth, &cubes);
+}
+
+#endif
@@ -0,0 +1,683 @@
+#ifndef PROOF_CHECKER_H
+#define PROOF_CHECKER_H
+
+#include <unordered_map>
+#include "ProofLogging.h"
+
+/* Checks a DRAT proof of unsatisfiability against the formula it refutes.
+ * A forward pass adds the lemmas and applies the deletions until unit
+ * propagation on what is active finds a conflict; the rest of the proof is not
+ * needed. A backward pass then undoes the proof step by step and checks only
+ * the lemmas marked as used (core), starting from the clauses in that final
+ * conflict. Each check assigns the negation of the lemma and propagates,
+ * expecting a conflict (RUP); failing that, every resolvent on the lemma's
+ * first literal must be RUP (RAT). Conflict analysis marks the clauses the
+ * check used as core, so lemmas nothing depends on are never checked.
+ * Propagation goes through core clauses first and uses a non-core clause only
+ * when core clauses imply nothing more, which keeps the core small.
+ *
+ * Deleting a unit clause, or a clause that is the reason of a top level
+ * assignment, is ignored, the way drat-trim does, since solvers routinely
+ * delete satisfied reasons.
+ * The hints of every checked lemma are kept, so a trimmed LRAT proof holding
+ * just the core lemmas can be written afterwards.
+ * Proofs are read in binary (as ProofWriter writes them) or text DRAT.
+*/
+
+// one line of the proof; clause is -1 for deletions that are ignored
+struct ProofStep
+{
+    int clause;
+    bool is_deletion;
+};
+
+class DratChecker
+{
+    struct CheckedClause
+    {
+        int start;        // literals[start .. start + size)
+        int size;
+        Lit pivot;        // first literal as written, the one RAT is checked on
+        bool is_active;
+        bool is_core;
+        bool is_lemma;
+        int hint_start;   // checked lemmas: hints[hint_start .. hint_start + hint_size)
+        int hint_size;
+    };
+
+    // the clause watches literal; blocker is its other watched literal when attached
+    struct Watcher
+    {
+        int clause;
+        Lit blocker;
+    };
+
+    int num_variables = 0;
+    int num_input_clauses = 0;
+    vector<Lit> literals;
+    vector<CheckedClause> clauses;
+    vector<ProofStep> steps;
+    // clauses by hash of their literal set, to find the clause a deletion names
+    unordered_map<uint64_t, vector<int>> clauses_by_hash;
+
+    vector<vector<Watcher>> watches;
+    vector<signed char> literal_values;
+    // per variable: the clause that implied it, -1 for the negated lemma literals of a check
+    vector<int> reasons;
+    vector<int> trail_positions;
+    vector<Lit> trail;
+    // next trail literal to propagate through core clauses, and through the others
+    int core_head = 0;
+    int other_head = 0;
+    // active clauses of size 1, asserted again whenever the top level is backtracked
+    vector<int> unit_clauses;
+    vector<char> seen;
+    vector<char> marked;
+
+    /* hints of the checked lemmas: clause index + 1, in propagation order, ending with
+     * the conflicting clause; a RAT candidate appears as -(index + 1) before its own hints
+    */
+    vector<int64_t> hints;
+    vector<int64_t> chain;
+    vector<int64_t> empty_clause_hints;
+    // last step the refutation needs; -1 if the formula alone propagates to a conflict
+    int conflict_step = -1;
+
+    static uint64_t clauseHash(const Lit* clause_literals, int size);
+    bool parseProof(const vector<char>& proof);
+    void addClause(vector<Lit>& clause, bool is_lemma);
+    int findClause(const vector<Lit>& clause);
+    void assign(Lit literal, int reason);
+    int attach(int clause);
+    void activate(int clause, int& conflict);
+    void deactivate(int clause);
+    bool isReason(int clause);
+    void backtrackTopLevel(int position);
+    void backtrackCheck(int position);
+    int propagate();
+    void markCore(int clause);
+    void analyze(int conflict, int true_variable);
+    bool propagatesToConflict(const Lit* first, int first_size, const Lit* second, int second_size, Lit skipped);
+    bool checkLemma(int clause);
+
+public:
+    long long num_lemmas = 0;
+    long long num_core_lemmas = 0;
+    long long num_rat_lemmas = 0;
+    long long num_ignored_deletions = 0;
+    // why the last verify() failed
+    string failure;
+
+    // true if proof refutes formula
+    bool verify(const CNFFormula& formula, const vector<char>& proof);
+    // after a successful verify(): the core lemmas as LRAT, with deletions after each clause's last use
+    bool writeLrat(const string& path);
+};
+
+// order independent, so a deletion can list the literals in any order
+inline uint64_t DratChecker::clauseHash(const Lit* clause_literals, int size) {
+    uint64_t hash = size;
+    for (int k = 0; k < size; k++) {
+        uint64_t mixed = (clause_literals[k] + 1) * 0x9E3779B97F4A7C15ULL;
+        mixed ^= mixed >> 29;
+        hash += mixed * 0xBF58476D1CE4E5B9ULL;
+    }
+    return hash;
+}
+
+// binary proofs have bytes that never appear in text DRAT early on
+inline bool isBinaryProof(const vector<char>& proof) {
+    for (int i = 0; i < proof.size() && i < 1024; i++) {
+        char c = proof[i];
+        if ((c >= '0' && c <= '9') || c == '-' || c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == 'd' || c == 'c') continue;
+        return true;
+    }
+    return false;
+}
+
+// reads the proof into steps, adding a clause per lemma; false on malformed input
+inline bool DratChecker::parseProof(const vector<char>& proof) {
+    vector<Lit> clause;
+    if (isBinaryProof(proof)) {
+        size_t i = 0;
+        while (i < proof.size()) {
+            char kind = proof[i++];
+            if (kind != 'a' && kind != 'd') {
+                failure = "unexpected byte in binary proof";
+                return false;
+            }
+            clause.clear();
+            while (true) {
+                uint64_t number = 0;
+                int shift = 0;
+                unsigned char byte;
+                do {
+                    if (i >= proof.size() || shift > 56) {
+                        failure = "truncated binary proof";
+                        return false;
+                    }
+                    byte = proof[i++];
+                    number |= (uint64_t) (byte & 127) << shift;
+                    shift += 7;
+                } while (byte & 128);
+                if (number == 0) break;
+                if (number < 2 || number / 2 > INT_MAX) {
+                    failure = "bad literal in binary proof";
+                    return false;
+                }
+                clause.push_back((Lit) (number - 2));
+            }
+            if (kind == 'd') steps.push_back({findClause(clause), true});
+            else addClause(clause, true);
+        }
+        return true;
+    }
+
+    const char* position = proof.data();
+    const char* end = proof.data() + proof.size();
+    bool is_deletion = false;
+    clause.clear();
+    while (position < end) {
+        char c = *position;
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            position++;
+        } else if (c == 'c') {
+            while (position < end && *position != '\n') position++;
+        } else if (c == 'd') {
+            is_deletion = true;
+            position++;
+        } else {
+            bool is_negative = c == '-';
+            if (is_negative) position++;
+            long long literal = 0;
+            const char* digits = position;
+            while (position < end && *position >= '0' && *position <= '9' && literal <= INT_MAX) {
+                literal = 10 * literal + (*position++ - '0');
+            }
+            if (position == digits || literal > INT_MAX) {
+                failure = "unexpected text in proof";
+                return false;
+            }
+            if (is_negative) literal = -literal;
+            if (literal != 0) {
+                clause.push_back(fromDimacs((int) literal));
+                continue;
+            }
+            if (is_deletion) steps.push_back({findClause(clause), true});
+            else addClause(clause, true);
+            is_deletion = false;
+            clause.clear();
+        }
+    }
+    return true;
+}
+
+/* stores a clause without repeated literals, keeping the first literal first.
+ * Tautologies are dropped: they can neither propagate nor be needed.
+*/
+inline void DratChecker::addClause(vector<Lit>& clause, bool is_lemma) {
+    int max_literal = 0;
+    for (int k = 0; k < clause.size(); k++) max_literal = max(max_literal, (int) clause[k]);
+    if (max_literal / 2 >= num_variables) {
+        // lemmas may introduce variables of their own
+        num_variables = max_literal / 2 + 1;
+        watches.resize(2 * num_variables);
+        literal_values.resize(2 * num_variables, LIT_UNASSIGNED);
+        reasons.resize(num_variables, -1);
+        trail_positions.resize(num_variables, 0);
+        seen.resize(num_variables, 0);
+        marked.resize(2 * num_variables, 0);
+    }
+    int size = 0;
+    bool is_tautology = false;
+    for (int k = 0; k < clause.size(); k++) {
+        if (marked[negateLiteral(clause[k])]) is_tautology = true;
+        if (marked[clause[k]]) continue;
+        marked[clause[k]] = 1;
+        clause[size++] = clause[k];
+    }
+    clause.resize(size);
+    for (int k = 0; k < size; k++) marked[clause[k]] = 0;
+    if (is_tautology) return;
+
+    int index = clauses.size();
+    clauses.push_back({(int) literals.size(), size, size > 0 ? clause[0] : 0, false, false, is_lemma, 0, 0});
+    literals.insert(literals.end(), clause.begin(), clause.end());
+    clauses_by_hash[clauseHash(clause.data(), size)].push_back(index);
+    if (is_lemma) {
+        steps.push_back({index, false});
+        num_lemmas++;
+    }
+}
+
+// the clause a deletion names; its matching clause must be added earlier in the proof
+inline int DratChecker::findClause(const vector<Lit>& clause) {
+    if (clause.empty()) return -1;
+    auto bucket = clauses_by_hash.find(clauseHash(clause.data(), clause.size()));
+    if (bucket == clauses_by_hash.end()) return -1;
+    int max_literal = 0;
+    for (int k = 0; k < clause.size(); k++) max_literal = max(max_literal, (int) clause[k]);
+    if (max_literal >= marked.size()) return -1;
+    int found = -1;
+    int num_distinct = 0;
+    for (int k = 0; k < clause.size(); k++) {
+        if (!marked[clause[k]]) num_distinct++;
+        marked[clause[k]] = 1;
+    }
+    vector<int>& candidates = bucket->second;
+    for (int i = (int) candidates.size() - 1; i >= 0 && found < 0; i--) {
+        const CheckedClause& candidate = clauses[candidates[i]];
+        if (candidate.size != num_distinct) continue;
+        bool is_match = true;
+        for (int k = 0; k < candidate.size && is_match; k++) is_match = marked[literals[candidate.start + k]];
+        if (!is_match) continue;
+        found = candidates[i];
+        // each deletion takes one copy
+        candidates[i] = candidates.back();
+        candidates.pop_back();
+    }
+    for (int k = 0; k < clause.size(); k++) marked[clause[k]] = 0;
+    return found;
+}
+
+inline void DratChecker::assign(Lit literal, int reason) {
+    literal_values[literal] = LIT_TRUE;
+    literal_values[negateLiteral(literal)] = LIT_FALSE;
+    reasons[literalVariable(literal)] = reason;
+    trail_positions[literalVariable(literal)] = trail.size();
+    trail.push_back(literal);
+}
+
+/* watches the two best literals of a clause of size >= 2: true ones first, then
+ * unassigned ones, then false ones assigned latest. Returns the clause if every
+ * literal is false; a clause left with one unassigned literal propagates it.
+*/
+inline int DratChecker::attach(int clause) {
+    Lit* clause_literals = &literals[clauses[clause].start];
+    int size = clauses[clause].size;
+    auto rank = [&](Lit literal) {
+        if (literal_values[literal] == LIT_TRUE) return INT_MAX;
+        if (literal_values[literal] == LIT_UNASSIGNED) return INT_MAX - 1;
+        return trail_positions[literalVariable(literal)];
+    };
+    for (int w = 0; w < 2; w++) {
+        int best = w;
+        for (int k = w + 1; k < size; k++) {
+            if (rank(clause_literals[k]) > rank(clause_literals[best])) best = k;
+        }
+        swap(clause_literals[w], clause_literals[best]);
+    }
+    watches[clause_literals[0]].push_back({clause, clause_literals[1]});
+    watches[clause_literals[1]].push_back({clause, clause_literals[0]});
+    if (literal_values[clause_literals[0]] == LIT_FALSE) return clause;
+    if (literal_values[clause_literals[1]] == LIT_FALSE && literal_values[clause_literals[0]] == LIT_UNASSIGNED) {
+        assign(clause_literals[0], clause);
+    }
+    return -1;
+}
+
+// makes a clause part of the formula again; conflict is set to a falsified clause if there is one
+inline void DratChecker::activate(int clause, int& conflict) {
+    CheckedClause& checked = clauses[clause];
+    checked.is_active = true;
+    if (checked.size == 0) {
+        conflict = clause;
+    } else if (checked.size == 1) {
+        unit_clauses.push_back(clause);
+        Lit unit = literals[checked.start];
+        if (literal_values[unit] == LIT_FALSE) conflict = clause;
+        else if (literal_values[unit] == LIT_UNASSIGNED) assign(unit, clause);
+    } else {
+        int falsified = attach(clause);
+        if (falsified >= 0) conflict = falsified;
+    }
+}
+
+// propagation keeps the implied literal of a clause first
+inline bool DratChecker::isReason(int clause) {
+    Lit first = literals[clauses[clause].start];
+    return literal_values[first] == LIT_TRUE && reasons[literalVariable(first)] == clause;
+}
+
+/* takes a clause out of the formula; what it implied at the top level, and
+ * everything assigned after it, is undone and propagated again
+*/
+inline void DratChecker::deactivate(int clause) {
+    CheckedClause& checked = clauses[clause];
+    checked.is_active = false;
+    if (checked.size == 0) return;
+    Lit first = literals[checked.start];
+    bool is_reason = isReason(clause);
+    if (checked.size == 1) {
+        unit_clauses.erase(find(unit_clauses.begin(), unit_clauses.end(), clause));
+    } else {
+        for (int w = 0; w < 2; w++) {
+            vector<Watcher>& list = watches[literals[checked.start + w]];
+            for (int i = 0; i < list.size(); i++) {
+                if (list[i].clause != clause) continue;
+                list[i] = list.back();
+                list.pop_back();
+                break;
+            }
+        }
+    }
+    if (is_reason) backtrackTopLevel(trail_positions[literalVariable(first)]);
+}
+
+/* unassigns trail[position ..]. Clauses that propagated those literals may now be
+ * unit on a false watched literal, so propagation starts over from the beginning.
+*/
+inline void DratChecker::backtrackTopLevel(int position) {
+    backtrackCheck(position);
+    core_head = 0;
+    other_head = 0;
+    for (int i = 0; i < unit_clauses.size(); i++) {
+        Lit unit = literals[clauses[unit_clauses[i]].start];
+        if (literal_values[unit] == LIT_UNASSIGNED) assign(unit, unit_clauses[i]);
+    }
+    propagate();
+}
+
+// undoes the assignments of a check; the top level below position was fully propagated
+inline void DratChecker::backtrackCheck(int position) {
+    for (int i = position; i < trail.size(); i++) {
+        literal_values[trail[i]] = LIT_UNASSIGNED;
+        literal_values[negateLiteral(trail[i])] = LIT_UNASSIGNED;
+    }
+    trail.resize(position);
+    core_head = min(core_head, position);
+    other_head = min(other_head, position);
+}
+
+/* core first unit propagation: each trail literal goes through the core clauses
+ * watching its negation before any literal goes through the non-core ones.
+ * Returns a falsified clause, or -1.
+*/
+inline int DratChecker::propagate() {
+    while (true) {
+        bool is_core_pass = core_head < trail.size();
+        if (!is_core_pass && other_head == trail.size()) return -1;
+        Lit false_literal = negateLiteral(trail[is_core_pass ? core_head++ : other_head++]);
+        vector<Watcher>& list = watches[false_literal];
+        int j = 0;
+        for (int i = 0; i < list.size(); i++) {
+            Watcher watcher = list[i];
+            const CheckedClause& checked = clauses[watcher.clause];
+            if (checked.is_core != is_core_pass || literal_values[watcher.blocker] == LIT_TRUE) {
+                list[j++] = watcher;
+                continue;
+            }
+            Lit* clause_literals = &literals[checked.start];
+            if (clause_literals[0] == false_literal) swap(clause_literals[0], clause_literals[1]);
+            if (literal_values[clause_literals[0]] == LIT_TRUE) {
+                list[j++] = {watcher.clause, clause_literals[0]};
+                continue;
+            }
+            int replacement = 0;
+            for (int k = 2; k < checked.size; k++) {
+                if (literal_values[clause_literals[k]] != LIT_FALSE) {
+                    replacement = k;
+                    break;
+                }
+            }
+            if (replacement > 0) {
+                swap(clause_literals[1], clause_literals[replacement]);
+                watches[clause_literals[1]].push_back({watcher.clause, clause_literals[0]});
+                continue;
+            }
+            list[j++] = watcher;
+            if (literal_values[clause_literals[0]] == LIT_FALSE) {
+                for (i++; i < list.size(); i++) list[j++] = list[i];
+                list.resize(j);
+                return watcher.clause;
+            }
+            assign(clause_literals[0], watcher.clause);
+        }
+        list.resize(j);
+    }
+}
+
+inline void DratChecker::markCore(int clause) {
+    if (clauses[clause].is_core) return;
+    clauses[clause].is_core = true;
+    if (clauses[clause].is_lemma) num_core_lemmas++;
+}
+
+/* marks the clauses a conflict depends on as core and leaves their hints in chain.
+ * The conflict is a falsified clause, or (conflict -1) a variable assigned true
+ * at the top level whose negation was just assumed.
+*/
+inline void DratChecker::analyze(int conflict, int true_variable) {
+    chain.clear();
+    if (conflict >= 0) {
+        markCore(conflict);
+        const CheckedClause& checked = clauses[conflict];
+        for (int k = 0; k < checked.size; k++) seen[literalVariable(literals[checked.start + k])] = 1;
+    } else {
+        seen[true_variable] = 1;
+    }
+    for (int i = (int) trail.size() - 1; i >= 0; i--) {
+        int variable = literalVariable(trail[i]);
+        if (!seen[variable]) continue;
+        seen[variable] = 0;
+        int reason = reasons[variable];
+        if (reason < 0) continue;
+        markCore(reason);
+        chain.push_back(reason + 1);
+        const CheckedClause& checked = clauses[reason];
+        for (int k = 0; k < checked.size; k++) {
+            int other = literalVariable(literals[checked.start + k]);
+            if (other != variable) seen[other] = 1;
+        }
+    }
+    reverse(chain.begin(), chain.end());
+    if (conflict >= 0) chain.push_back(conflict + 1);
+}
+
+/* assumes the negations of first and of second (without skipped) and propagates.
+ * True if that conflicts, with the hints in chain; an assumption clashing with
+ * another one counts as a conflict needing no hints.
+*/
+inline bool DratChecker::propagatesToConflict(const Lit* first, int first_size, const Lit* second, int second_size, Lit skipped) {
+    int saved = trail.size();
+    int true_variable = -1;
+    bool is_clash = false;
+    for (int k = 0; k < first_size + second_size && true_variable < 0 && !is_clash; k++) {
+        Lit literal = k < first_size ? first[k] : second[k - first_size];
+        if (k >= first_size && literal == skipped) continue;
+        if (literal_values[literal] == LIT_TRUE) {
+            if (trail_positions[literalVariable(literal)] >= saved) is_clash = true;
+            else true_variable = literalVariable(literal);
+        } else if (literal_values[literal] == LIT_UNASSIGNED) {
+            assign(negateLiteral(literal), -1);
+        }
+    }
+    bool is_refuted = true;
+    chain.clear();
+    if (true_variable >= 0) {
+        analyze(-1, true_variable);
+    } else if (!is_clash) {
+        int conflict = propagate();
+        if (conflict >= 0) analyze(conflict, -1);
+        else is_refuted = false;
+    }
+    backtrackCheck(saved);
+    return is_refuted;
+}
+
+// RUP, else RAT on the pivot; the lemma itself is no longer active
+inline bool DratChecker::checkLemma(int clause) {
+    CheckedClause& checked = clauses[clause];
+    const Lit* lemma = &literals[checked.start];
+    checked.hint_start = hints.size();
+    if (propagatesToConflict(lemma, checked.size, nullptr, 0, 0)) {
+        hints.insert(hints.end(), chain.begin(), chain.end());
+        checked.hint_size = chain.size();
+        return true;
+    }
+
+    Lit resolved = negateLiteral(checked.pivot);
+    for (int candidate = 0; candidate < clauses.size(); candidate++) {
+        const CheckedClause& partner = clauses[candidate];
+        if (!partner.is_active) continue;
+        const Lit* partner_literals = &literals[partner.start];
+        if (find(partner_literals, partner_literals + partner.size, resolved) == partner_literals + partner.size) continue;
+        if (!propagatesToConflict(lemma, checked.size, partner_literals, partner.size, resolved)) {
+            hints.resize(checked.hint_start);
+            return false;
+        }
+        markCore(candidate);
+        hints.push_back(-(int64_t) (candidate + 1));
+        hints.insert(hints.end(), chain.begin(), chain.end());
+    }
+    checked.hint_size = hints.size() - checked.hint_start;
+    num_rat_lemmas++;
+    return true;
+}
+
+inline bool DratChecker::verify(const CNFFormula& formula, const vector<char>& proof) {
+    num_variables = formula.num_variables;
+    num_input_clauses = formula.numClauses();
+    watches.assign(2 * num_variables, vector<Watcher>());
+    literal_values.assign(2 * num_variables, LIT_UNASSIGNED);
+    reasons.assign(num_variables, -1);
+    trail_positions.assign(num_variables, 0);
+    seen.assign(num_variables, 0);
+    marked.assign(2 * num_variables, 0);
+    literals.clear();
+    clauses.clear();
+    steps.clear();
+    clauses_by_hash.clear();
+    trail.clear();
+    unit_clauses.clear();
+    hints.clear();
+    core_head = 0;
+    other_head = 0;
+    num_lemmas = num_core_lemmas = num_rat_lemmas = num_ignored_deletions = 0;
+    failure.clear();
+
+    // input clause i is clause i, so it keeps id i + 1 in an LRAT proof
+    int conflict = -1;
+    vector<Lit> clause;
+    for (int i = 0; i < num_input_clauses; i++) {
+        clause.assign(formula.clauseLiterals(i), formula.clauseLiterals(i) + formula.clauseSize(i));
+        addClause(clause, false);
+        if (clauses.size() == i + 1) {
+            if (conflict < 0) activate(i, conflict);
+        } else {
+            // a tautology; keeps the numbering with a clause that never takes part
+            clauses.push_back({(int) literals.size(), 0, 0, false, false, false, 0, 0});
+        }
+    }
+    if (!parseProof(proof)) return false;
+
+    // forward: play the proof until the active clauses propagate to a conflict
+    if (conflict < 0) conflict = propagate();
+    conflict_step = -1;
+    for (int s = 0; s < steps.size() && conflict < 0; s++) {
+        ProofStep& step = steps[s];
+        if (step.clause < 0) {
+            if (step.is_deletion) num_ignored_deletions++;
+            continue;
+        }
+        if (step.is_deletion) {
+            const CheckedClause& checked = clauses[step.clause];
+            if (checked.size <= 1 || isReason(step.clause)) {
+                num_ignored_deletions++;
+                step.clause = -1;
+            } else {
+                deactivate(step.clause);
+            }
+            continue;
+        }
+        if (clauses[step.clause].size == 0) {
+            failure = "the empty clause at step " + to_string(s + 1) + " does not follow by unit propagation";
+            return false;
+        }
+        activate(step.clause, conflict);
+        if (conflict < 0) conflict = propagate();
+        conflict_step = s;
+    }
+    if (conflict < 0) {
+        failure = "no conflict: the proof does not refute the formula";
+        return false;
+    }
+
+    // backward: undo the proof and check the lemmas the refutation uses
+    analyze(conflict, -1);
+    empty_clause_hints = chain;
+    for (int s = conflict_step; s >= 0; s--) {
+        const ProofStep& step = steps[s];
+        if (step.clause < 0) continue;
+        if (step.is_deletion) {
+            int unused_conflict = -1;
+            activate(step.clause, unused_conflict);
+            propagate();
+            continue;
+        }
+        deactivate(step.clause);
+        propagate();
+        if (clauses[step.clause].is_core && !checkLemma(step.clause)) {
+            failure = "lemma at step " + to_string(s + 1) + " is neither RUP nor RAT";
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool DratChecker::writeLrat(const string& path) {
+    ProofWriter writer;
+    if (!writer.open(path, ProofFormat::lrat)) return false;
+
+    // core lemmas in proof order, then the empty clause, are the lines of the proof
+    vector<int> lines;
+    for (int s = 0; s <= conflict_step; s++) {
+        if (!steps[s].is_deletion && steps[s].clause >= 0 && clauses[steps[s].clause].is_core) lines.push_back(steps[s].clause);
+    }
+    vector<uint64_t> new_ids(clauses.size(), 0);
+    for (int i = 0; i < num_input_clauses; i++) new_ids[i] = i + 1;
+    uint64_t next_id = num_input_clauses + 1;
+    for (int l = 0; l < lines.size(); l++) new_ids[lines[l]] = next_id++;
+
+    // every clause is deleted right after the line that uses it last
+    vector<int> last_use(clauses.size(), -1);
+    for (int l = 0; l < lines.size(); l++) {
+        const CheckedClause& checked = clauses[lines[l]];
+        for (int h = 0; h < checked.hint_size; h++) last_use[llabs(hints[checked.hint_start + h]) - 1] = l;
+    }
+    // the empty clause uses its hints last, and nothing is deleted after it
+    for (int h = 0; h < empty_clause_hints.size(); h++) last_use[empty_clause_hints[h] - 1] = lines.size();
+    vector<vector<int>> deleted_after(lines.size());
+    for (int c = 0; c < clauses.size(); c++) {
+        if (c < num_input_clauses && last_use[c] < 0) {
+            writer.deleteClause(c + 1);
+        } else if (last_use[c] >= 0 && last_use[c] < lines.size()) {
+            deleted_after[last_use[c]].push_back(c);
+        }
+    }
+
+    vector<Lit> clause;
+    vector<int64_t> mapped_hints;
+    for (int l = 0; l < lines.size(); l++) {
+        const CheckedClause& checked = clauses[lines[l]];
+        // the pivot leads, as RAT lemmas need
+        clause.assign(1, checked.pivot);
+        for (int k = 0; k < checked.size; k++) {
+            if (literals[checked.start + k] != checked.pivot) clause.push_back(literals[checked.start + k]);
+        }
+        mapped_hints.clear();
+        for (int h = 0; h < checked.hint_size; h++) {
+            int64_t hint = hints[checked.hint_start + h];
+            int64_t id = new_ids[llabs(hint) - 1];
+            mapped_hints.push_back(hint < 0 ? -id : id);
+        }
+        writer.addClause(new_ids[lines[l]], clause.data(), clause.size(), mapped_hints);
+        for (int i = 0; i < deleted_after[l].size(); i++) writer.deleteClause(new_ids[deleted_after[l][i]]);
+    }
+    mapped_hints.clear();
+    for (int h = 0; h < empty_clause_hints.size(); h++) mapped_hints.push_back(new_ids[empty_clause_hints[h] - 1]);
+    writer.addClause(next_id, nullptr, 0, mapped_hints);
+    return writer.close();
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef PROOF_LOGGING_H
+#define PROOF_LOGGING_H
+
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "SolverCommon.h"
+
+/* Clausal proofs of unsatisfiability, in the binary formats checkers read.
+ * DRAT: 'a' or 'd', then each literal as a number 2 * variable + sign
+ * (1-indexed variable, sign 1 for negative), then 0.
+ * LRAT: 'a', the clause id, the literals, 0, the ids of the clauses that make it
+ * follow by unit propagation, in propagation order, 0; deletions are 'd', ids, 0.
+ * Ids are written as 2 * id. Numbers are little-endian base 128, with the high
+ * bit set on every byte but the last.
+ *
+ * Lines are appended to an in-memory buffer; full buffers are handed to a
+ * writer thread, so search only waits on the disk if the writer falls
+ * PROOF_MAX_PENDING_BUFFERS buffers behind.
+*/
+
+const size_t PROOF_BUFFER_BYTES = 1 << 20;
+const int PROOF_MAX_PENDING_BUFFERS = 16;
+
+enum class ProofFormat
+{
+    drat,
+    lrat
+};
+
+class ProofWriter
+{
+    FILE* file = nullptr;
+    ProofFormat format = ProofFormat::drat;
+    vector<char> buffer;
+    // full buffers waiting for the writer thread, and emptied ones to reuse
+    deque<vector<char>> pending_buffers;
+    vector<vector<char>> spare_buffers;
+    bool is_closing = false;
+    // a write failed: the file on disk is not the whole proof
+    bool has_failed = false;
+    mutex buffers_mutex;
+    condition_variable has_pending;
+    condition_variable has_room;
+    thread writer;
+
+    void writerLoop();
+    void handOverBuffer();
+
+    void writeNumber(uint64_t number) {
+        while (number > 127) {
+            buffer.push_back((char) ((number & 127) | 128));
+            number >>= 7;
+        }
+        buffer.push_back((char) number);
+    }
+
+    // 2 * (variable + 1) + sign is the packed literal plus 2
+    void writeLiterals(const Lit* literals, int size) {
+        for (int i = 0; i < size; i++) writeNumber((uint64_t) literals[i] + 2);
+        buffer.push_back(0);
+    }
+
+    void endLine() {
+        if (buffer.size() >= PROOF_BUFFER_BYTES) handOverBuffer();
+    }
+
+public:
+    ~ProofWriter() { close(); }
+
+    // returns false if the file cannot be created
+    bool open(const string& path, ProofFormat proof_format);
+    // writes out everything still buffered and closes the file; false if any of it could not be written
+    bool close();
+    bool isOpen() const { return file != nullptr; }
+    ProofFormat getFormat() const { return format; }
+
+    // DRAT lines
+    void addClause(const Lit* literals, int size) {
+        buffer.push_back('a');
+        writeLiterals(literals, size);
+        endLine();
+    }
+
+    void deleteClause(const Lit* literals, int size) {
+        buffer.push_back('d');
+        writeLiterals(literals, size);
+        endLine();
+    }
+
+    // LRAT lines
+    void addClause(uint64_t id, const Lit* literals, int size, const vector<uint64_t>& hints) {
+        buffer.push_back('a');
+        writeNumber(2 * id);
+        writeLiterals(literals, size);
+        for (int i = 0; i < hints.size(); i++) writeNumber(2 * hints[i]);
+        buffer.push_back(0);
+        endLine();
+    }
+
+    // LRAT line whose hints may name RAT candidates, as negative ids
+    void addClause(uint64_t id, const Lit* literals, int size, const vector<int64_t>& hints) {
+        buffer.push_back('a');
+        writeNumber(2 * id);
+        writeLiterals(literals, size);
+        for (int i = 0; i < hints.size(); i++) {
+            writeNumber(hints[i] < 0 ? 2 * (uint64_t) -hints[i] + 1 : 2 * (uint64_t) hints[i]);
+        }
+        buffer.push_back(0);
+        endLine();
+    }
+
+    void deleteClause(uint64_t id) {
+        buffer.push_back('d');
+        writeNumber(2 * id);
+        buffer.push_back(0);
+        endLine();
+    }
+};
+
+inline bool ProofWriter::open(const string& path, ProofFormat proof_format) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    format = proof_format;
+    is_closing = false;
+    has_failed = false;
+    buffer.clear();
+    buffer.reserve(PROOF_BUFFER_BYTES + 1024);
+    writer = thread(&ProofWriter::writerLoop, this);
+    return true;
+}
+
+inline void ProofWriter::handOverBuffer() {
+    unique_lock<mutex> guard(buffers_mutex);
+    has_room.wait(guard, [this] { return pending_buffers.size() < PROOF_MAX_PENDING_BUFFERS; });
+    pending_buffers.push_back(move(buffer));
+    if (spare_buffers.empty()) {
+        buffer = vector<char>();
+        buffer.reserve(PROOF_BUFFER_BYTES + 1024);
+    } else {
+        buffer = move(spare_buffers.back());
+        spare_buffers.pop_back();
+    }
+    has_pending.notify_one();
+}
+
+inline void ProofWriter::writerLoop() {
+    unique_lock<mutex> guard(buffers_mutex);
+    while (true) {
+        has_pending.wait(guard, [this] { return !pending_buffers.empty() || is_closing; });
+        if (pending_buffers.empty()) return;
+        vector<char> chunk = move(pending_buffers.front());
+        pending_buffers.pop_front();
+        has_room.notify_one();
+        // write without holding the lock, so search can keep handing over buffers
+        guard.unlock();
+        // after a failed write the rest is dropped; the proof is broken either way
+        bool is_written = !has_failed && fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+        chunk.clear();
+        guard.lock();
+        if (!is_written) has_failed = true;
+        spare_buffers.push_back(move(chunk));
+    }
+}
+
+inline bool ProofWriter::close() {
+    if (!file) return true;
+    if (!buffer.empty()) handOverBuffer();
+    {
+        lock_guard<mutex> guard(buffers_mutex);
+        is_closing = true;
+    }
+    has_pending.notify_one();
+    writer.join();
+    // fclose flushes what stdio still buffers, so it can fail as well
+    bool is_complete = fclose(file) == 0 && !has_failed;
+    file = nullptr;
+    spare_buffers.clear();
+    return is_complete;
+}
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <sys/file.h>
+#include "Checkpoint.h"
+
+/* Results of formulas already solved, for drivers that see the same CNF
+ * again: batch runs, the server and repeated single runs.
+ *
+ * A formula is keyed by a 128-bit hash of its normalized clause set: the
+ * literals of each clause sorted and deduplicated, the clauses sorted and
+ * deduplicated, and the variable count, so the order of clauses and
+ * literals and repeated clauses do not change the key. Only SAT and UNSAT
+ * results are kept, with the model of a SAT result and the statistics of
+ * the search that found it. A cached model is checked against the formula
+ * before it is answered, so a hash collision costs a solve, not a wrong model.
+ *
+ * In memory, up to max_entries results are kept, the oldest dropped first.
+ * The optional on-disk index is a file mapped shared, so every process that
+ * opens it sees the others' results; flock serializes them:
+ *   CacheIndexHeader
+ *   CacheSlot    slots[num_slots]   open addressing with linear probing
+ *   uint64_t     models[]           bit v of a model is variable v, appended
+ * The slot table is sized when the file is created; once it is half full,
+ * new results stay in memory.
+*/
+
+const uint32_t CACHE_INDEX_VERSION = 1;
+const char CACHE_INDEX_MAGIC[8] = {'S', 'A', 'T', 'C', 'A', 'C', 'H', 'E'};
+const uint64_t DEFAULT_CACHE_INDEX_SLOTS = 1 << 16;
+const size_t DEFAULT_CACHE_ENTRIES = 4096;
+// the model area a new index file starts with
+const uint64_t CACHE_INDEX_INITIAL_DATA = 1 << 20;
+
+struct CacheKey
+{
+    uint64_t hash[2];
+
+    bool operator==(const CacheKey& other) const { return hash[0] == other.hash[0] && hash[1] == other.hash[1]; }
+};
+
+struct CacheKeyHash
+{
+    size_t operator()(const CacheKey& key) const { return key.hash[0]; }
+};
+
+struct CachedResult
+{
+    ReturnValue result = ReturnValue::unknown;
+    int num_variables = 0;
+    // bit v is set if variable v is true; empty for UNSAT
+    vector<uint64_t> model;
+    SolverStatistics statistics;
+
+    bool modelValue(int variable) const { return model[variable >> 6] >> (variable & 63) & 1; }
+};
+
+// a second hash next to FNV-1a, so the key does not rest on a single 64-bit function
+inline uint64_t mixHash(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 29);
+}
+
+inline CacheKey canonicalFormulaKey(const CNFFormula& formula) {
+    // every clause normalized into one buffer, then ordered through (offset, size) pairs into it
+    vector<Lit> literals;
+    vector<pair<int, int>> clauses;
+    literals.reserve(formula.literals.size());
+    clauses.reserve(formula.numClauses());
+    for (int c = 0; c < formula.numClauses(); c++) {
+        int start = literals.size();
+        literals.insert(literals.end(), formula.clauseLiterals(c), formula.clauseLiterals(c) + formula.clauseSize(c));
+        sort(literals.begin() + start, literals.end());
+        literals.erase(unique(literals.begin() + start, literals.end()), literals.end());
+        clauses.push_back(make_pair(start, (int) literals.size() - start));
+    }
+    auto is_before = [&literals](const pair<int, int>& a, const pair<int, int>& b) {
+        if (a.second != b.second) return a.second < b.second;
+        return lexicographical_compare(literals.begin() + a.first, literals.begin() + a.first + a.second,
+                                       literals.begin() + b.first, literals.begin() + b.first + b.second);
+    };
+    sort(clauses.begin(), clauses.end(), is_before);
+
+    CacheKey key;
+    key.hash[0] = fnv1aHash((const char*) &formula.num_variables, sizeof(formula.num_variables));
+    key.hash[1] = mixHash(0x243f6a8885a308d3ULL, formula.num_variables);
+    for (int i = 0; i < clauses.size(); i++) {
+        // sorted, so a repeated clause follows its first copy
+        if (i > 0 && !is_before(clauses[i - 1], clauses[i])) continue;
+        const Lit* clause = literals.data() + clauses[i].first;
+        int size = clauses[i].second;
+        key.hash[0] = fnv1aHash((const char*) &size, sizeof(size), key.hash[0]);
+        key.hash[0] = fnv1aHash((const char*) clause, size * sizeof(Lit), key.hash[0]);
+        key.hash[1] = mixHash(key.hash[1], size);
+        for (int k = 0; k < size; k++) key.hash[1] = mixHash(key.hash[1], clause[k]);
+    }
+    return key;
+}
+
+// the result of a finished search, as the cache keeps it
+inline CachedResult makeCachedResult(SatSolver& solver, ReturnValue result) {
+    CachedResult cached;
+    cached.result = result;
+    cached.num_variables = solver.numVariables();
+    cached.statistics = solver.getStatistics();
+    if (result == ReturnValue::sat) {
+        cached.model.assign((cached.num_variables + 63) / 64, 0);
+        for (int v = 0; v < cached.num_variables; v++) {
+            if (solver.modelValue(v)) cached.model[v >> 6] |= 1ULL << (v & 63);
+        }
+    }
+    return cached;
+}
+
+inline bool isCachedModel(const CachedResult& cached, const CNFFormula& formula) {
+    if (cached.model.size() != (formula.num_variables + 63) / 64) return false;
+    for (int c = 0; c < formula.numClauses(); c++) {
+        bool is_satisfied = false;
+        for (int k = 0; k < formula.clauseSize(c) && !is_satisfied; k++) {
+            Lit literal = formula.clauseLiterals(c)[k];
+            is_satisfied = cached.modelValue(literalVariable(literal)) != isNegativeLiteral(literal);
+        }
+        if (!is_satisfied) return false;
+    }
+    return true;
+}
+
+// the same output as SatSolver::printResult() for a SAT or UNSAT result
+inline void printCachedResult(const CachedResult& cached, bool printSATliterals, ostream& out) {
+    if (cached.result == ReturnValue::sat) {
+        out << "SAT" << endl;
+        if (printSATliterals) {
+            for (int i = 0; i < cached.num_variables; i++) out << toDimacs(makeLiteral(i, !cached.modelValue(i))) << " ";
+            out << "0" << endl;
+        }
+    } else {
+        out << "UNSAT" << endl;
+    }
+}
+
+class ResultCache
+{
+    struct CacheIndexHeader
+    {
+        char magic[8];
+        uint32_t version;
+        // sizeof(CacheSlot) of the writer, so a changed layout is not misread
+        uint32_t slot_size;
+        uint64_t num_slots;
+        uint64_t num_entries;
+        // end of the models appended so far, from the start of the file
+        uint64_t data_end;
+    };
+
+    struct CacheSlot
+    {
+        uint64_t key[2];
+        uint64_t model_offset;
+        int32_t num_variables;
+        // ReturnValue + 1, 0 for an empty slot
+        int32_t result;
+        SolverStatistics statistics;
+    };
+
+    size_t max_entries;
+    unordered_map<CacheKey, CachedResult, CacheKeyHash> results;
+    deque<CacheKey> insertion_order;
+    mutex cache_mutex;
+
+    string index_path;
+    int index_fd = -1;
+    char* index = nullptr;
+    size_t index_size = 0;
+    bool has_warned_full = false;
+
+    CacheIndexHeader& indexHeader() { return *(CacheIndexHeader*) index; }
+    CacheSlot* indexSlots() { return (CacheSlot*) (index + sizeof(CacheIndexHeader)); }
+    bool mapIndex();
+    CacheSlot* probeIndex(const CacheKey& key);
+    bool lookupIndex(const CacheKey& key, CachedResult& cached);
+    void storeIndex(const CacheKey& key, const CachedResult& cached);
+    void storeInMemory(const CacheKey& key, const CachedResult& cached);
+
+public:
+    explicit ResultCache(size_t entries = DEFAULT_CACHE_ENTRIES) : max_entries(entries) {}
+    ~ResultCache() { closeIndex(); }
+
+    void setMaxEntries(size_t entries);
+    // opens or creates the on-disk index; false (with a message on cerr) if it cannot be used
+    bool openIndex(const string& path, uint64_t num_slots = DEFAULT_CACHE_INDEX_SLOTS);
+    void closeIndex();
+    bool isEnabled() const { return max_entries > 0 || index_fd >= 0; }
+    // the cached result of the formula with this key, if there is one that still checks out
+    bool lookup(const CacheKey& key, const CNFFormula& formula, CachedResult& cached);
+    // keeps a SAT or UNSAT result; UNKNOWN ones are not kept
+    void store(const CacheKey& key, const CachedResult& cached);
+};
+
+inline void ResultCache::setMaxEntries(size_t entries) {
+    lock_guard<mutex> guard(cache_mutex);
+    max_entries = entries;
+    while (insertion_order.size() > max_entries) {
+        results.erase(insertion_order.front());
+        insertion_order.pop_front();
+    }
+}
+
+// maps the whole file as it is now; called with the file locked
+inline bool ResultCache::mapIndex() {
+    struct stat file_status;
+    if (fstat(index_fd, &file_status) != 0) return false;
+    if (index) munmap(index, index_size);
+    index_size = file_status.st_size;
+    void* mapping = mmap(nullptr, index_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+    index = (mapping == MAP_FAILED) ? nullptr : (char*) mapping;
+    return index != nullptr;
+}
+
+inline bool ResultCache::openIndex(const string& path, uint64_t num_slots) {
+    lock_guard<mutex> guard(cache_mutex);
+    if (index_fd >= 0) {
+        munmap(index, index_size);
+        ::close(index_fd);
+        index = nullptr;
+        index_fd = -1;
+    }
+    index_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (index_fd < 0) {
+        cerr << "cannot open result cache " << path << endl;
+        return false;
+    }
+    flock(index_fd, LOCK_EX);
+    struct stat file_status;
+    bool is_usable = fstat(index_fd, &file_status) == 0;
+    if (is_usable && file_status.st_size == 0) {
+        // a new file: the zeroed slots ftruncate leaves are the empty ones
+        CacheIndexHeader header = {};
+        memcpy(header.magic, CACHE_INDEX_MAGIC, sizeof(CACHE_INDEX_MAGIC));
+        header.version = CACHE_INDEX_VERSION;
+        header.slot_size = sizeof(CacheSlot);
+        header.num_slots = max<uint64_t>(num_slots, 2);
+        header.data_end = sizeof(CacheIndexHeader) + header.num_slots * sizeof(CacheSlot);
+        is_usable = ftruncate(index_fd, header.data_end + CACHE_INDEX_INITIAL_DATA) == 0
+            && pwrite(index_fd, &header, sizeof(header), 0) == sizeof(header);
+    }
+    is_usable = is_usable && mapIndex() && index_size >= sizeof(CacheIndexHeader);
+    if (is_usable) {
+        const CacheIndexHeader& header = indexHeader();
+        is_usable = memcmp(header.magic, CACHE_INDEX_MAGIC, sizeof(CACHE_INDEX_MAGIC)) == 0
+            && header.version == CACHE_INDEX_VERSION && header.slot_size == sizeof(CacheSlot)
+            && header.num_slots > 0 && header.num_slots <= index_size / sizeof(CacheSlot)
+            && header.data_end >= sizeof(CacheIndexHeader) + header.num_slots * sizeof(CacheSlot)
+            && header.data_end <= index_size;
+    }
+    flock(index_fd, LOCK_UN);
+    if (!is_usable) {
+        // never overwrite a file that is not an index of this version
+        cerr << path << " is not a result cache of this version, not using it" << endl;
+        if (index) munmap(index, index_size);
+        ::close(index_fd);
+        index = nullptr;
+        index_fd = -1;
+        return false;
+    }
+    index_path = path;
+    has_warned_full = false;
+    return true;
+}
+
+inline void ResultCache::closeIndex() {
+    if (index_fd < 0) return;
+    munmap(index, index_size);
+    ::close(index_fd);
+    index = nullptr;
+    index_size = 0;
+    index_fd = -1;
+}
+
+// the slot holding the key, or the empty slot it would go into
+inline ResultCache::CacheSlot* ResultCache::probeIndex(const CacheKey& key) {
+    uint64_t num_slots = indexHeader().num_slots;
+    CacheSlot* slots = indexSlots();
+    // hash[1] picks the slot: the in-memory map already spreads on hash[0]
+    for (uint64_t i = key.hash[1] % num_slots, probes = 0; probes < num_slots; i = (i + 1) % num_slots, probes++) {
+        if (slots[i].result == 0 || (slots[i].key[0] == key.hash[0] && slots[i].key[1] == key.hash[1])) return &slots[i];
+    }
+    return nullptr;
+}
+
+inline bool ResultCache::lookupIndex(const CacheKey& key, CachedResult& cached) {
+    flock(index_fd, LOCK_SH);
+    CacheSlot* slot = probeIndex(key);
+    bool is_found = slot && slot->result != 0;
+    if (is_found) {
+        cached.result = (ReturnValue) (slot->result - 1);
+        cached.num_variables = slot->num_variables;
+        cached.statistics = slot->statistics;
+        cached.model.clear();
+        if (cached.result == ReturnValue::sat) {
+            uint64_t model_offset = slot->model_offset;
+            size_t model_size = (cached.num_variables + 63) / 64;
+            // another process may have grown the file since it was mapped
+            if (model_offset + model_size * sizeof(uint64_t) > index_size) is_found = mapIndex();
+            is_found = is_found && model_offset + model_size * sizeof(uint64_t) <= index_size;
+            if (is_found) {
+                const uint64_t* model = (const uint64_t*) (index + model_offset);
+                cached.model.assign(model, model + model_size);
+            }
+        }
+    }
+    flock(index_fd, LOCK_UN);
+    return is_found;
+}
+
+inline void ResultCache::storeIndex(const CacheKey& key, const CachedResult& cached) {
+    flock(index_fd, LOCK_EX);
+    CacheIndexHeader& header = indexHeader();
+    CacheSlot* slot = probeIndex(key);
+    if (!slot || slot->result != 0) {
+        flock(index_fd, LOCK_UN);
+        return;
+    }
+    if (2 * header.num_entries >= header.num_slots) {
+        if (!has_warned_full) cerr << "result cache " << index_path << " is full, keeping new results in memory" << endl;
+        has_warned_full = true;
+        flock(index_fd, LOCK_UN);
+        return;
+    }
+    uint64_t model_bytes = cached.model.size() * sizeof(uint64_t);
+    bool is_stored = true;
+    if (header.data_end + model_bytes > index_size) {
+        // the mapping may be stale before it is too small: look at the file first
+        struct stat file_status;
+        is_stored = fstat(index_fd, &file_status) == 0;
+        uint64_t needed = header.data_end + model_bytes;
+        if (is_stored && (uint64_t) file_status.st_size < needed) {
+            is_stored = ftruncate(index_fd, max(needed, 2 * (uint64_t) file_status.st_size)) == 0;
+        }
+        // remapping moves the header and the slots
+        is_stored = is_stored && mapIndex();
+        slot = is_stored ? probeIndex(key) : nullptr;
+    }
+    if (is_stored && slot) {
+        CacheIndexHeader& mapped_header = indexHeader();
+        slot->model_offset = mapped_header.data_end;
+        memcpy(index + mapped_header.data_end, cached.model.data(), model_bytes);
+        mapped_header.data_end += model_bytes;
+        slot->key[0] = key.hash[0];
+        slot->key[1] = key.hash[1];
+        slot->num_variables = cached.num_variables;
+        slot->statistics = cached.statistics;
+        // filled last: the result is what marks the slot as taken
+        slot->result = cached.result + 1;
+        mapped_header.num_entries++;
+    }
+    flock(index_fd, LOCK_UN);
+}
+
+inline void ResultCache::storeInMemory(const CacheKey& key, const CachedResult& cached) {
+    if (max_entries == 0 || !results.emplace(key, cached).second) return;
+    insertion_order.push_back(key);
+    if (insertion_order.size() > max_entries) {
+        results.erase(insertion_order.front());
+        insertion_order.pop_front();
+    }
+}
+
+inline bool ResultCache::lookup(const CacheKey& key, const CNFFormula& formula, CachedResult& cached) {
+    lock_guard<mutex> guard(cache_mutex);
+    auto found = results.find(key);
+    if (found != results.end()) {
+        cached = found->second;
+    } else if (index_fd < 0 || !lookupIndex(key, cached)) {
+        return false;
+    } else {
+        storeInMemory(key, cached);
+    }
+    if (cached.num_variables != formula.num_variables) return false;
+    return cached.result != ReturnValue::sat || isCachedModel(cached, formula);
+}
+
+inline void ResultCache::store(const CacheKey& key, const CachedResult& cached) {
+    if (cached.result == ReturnValue::unknown) return;
+    lock_guard<mutex> guard(cache_mutex);
+    storeInMemory(key, cached);
+    if (index_fd >= 0) storeIndex(key, cached);
+}
+
+#endif
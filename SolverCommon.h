@@ -0,0 +1,469 @@
+#ifndef SOLVER_COMMON_H
+#define SOLVER_COMMON_H
+
+// types shared by every solver engine and driver
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <time.h>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+enum ReturnValue
+{
+    sat,     // formula is satisfiable
+    unsat,   // formula is unsatisfiable
+    normal,  // formula satisfiability undetermined
+    unknown  // search stopped by a budget or an interrupt before deciding
+};
+
+// limits on a single call to solve(); -1 means unlimited
+struct SolverBudget
+{
+    long long max_conflicts = -1;
+    long long max_propagations = -1;
+    double max_seconds = -1;
+    long long max_memory_mb = -1;
+    // local search flips; CDCL ignores it
+    long long max_flips = -1;
+};
+
+// search settings of the CDCL engines; other engines ignore them
+struct SolverOptions
+{
+    // backjumps over more than this many levels only go back one level; -1 always backjumps
+    int chrono_backtrack_threshold = -1;
+    // conflicts in the first focused mode, for policies with a focused and a stable mode; -1 stays focused
+    long long mode_switch_conflicts = 1000;
+    // later modes last as many propagation ticks as the first one (doubling every two switches),
+    // instead of as many conflicts
+    bool mode_switch_by_ticks = true;
+    // conflicts before learned clauses are first reduced, each later reduction coming a bit later; -1 keeps all
+    long long reduce_interval = 2000;
+    // conflicts between vivification rounds, which run at the next restart; -1 never vivifies
+    long long vivify_interval = 2000;
+    // a round may use this fraction of the propagation ticks search used since the previous round
+    double vivify_effort = 0.1;
+    // also vivify input clauses, not just learned ones
+    bool vivify_irredundant = false;
+    // remove blocked clauses before search
+    bool blocked_clause_elimination = false;
+    // after blocked clauses, remove covered ones too (needs blocked_clause_elimination)
+    bool covered_clause_elimination = false;
+    // write a DRAT proof of unsatisfiability to this file; empty writes none
+    string proof_path;
+    // write LRAT instead of DRAT; clause ids start at load(), so set this before loading
+    bool proof_lrat = false;
+    // write snapshots of the search to this file, to resume from later; empty writes none.
+    // Snapshots name the formula by a hash taken at load(), so set this and resume_path before loading
+    string checkpoint_path;
+    // seconds between snapshots; a search stopped early writes a last one
+    double checkpoint_interval = 60;
+    // resume from this snapshot if it exists and was taken on the same formula
+    string resume_path;
+    // assignment hints (see readHints) for the drivers to suggest after loading; empty reads none
+    string hint_path;
+    // hinted variables start with their branching score plus this times the highest score
+    double hint_bias = 0;
+};
+
+/* reads one "--name value" budget or search option, as the drivers and the
+ * server take them; false if the name is not one of them
+*/
+inline bool parseSolveOption(const string& option, const string& value, SolverBudget& budget, SolverOptions& options) {
+    if (option == "--conflicts") budget.max_conflicts = stoll(value);
+    else if (option == "--propagations") budget.max_propagations = stoll(value);
+    else if (option == "--time") budget.max_seconds = stod(value);
+    else if (option == "--memory") budget.max_memory_mb = stoll(value);
+    else if (option == "--flips") budget.max_flips = stoll(value);
+    else if (option == "--chrono") options.chrono_backtrack_threshold = stoi(value);
+    else if (option == "--modes") options.mode_switch_conflicts = stoll(value);
+    else if (option == "--mode-ticks") options.mode_switch_by_ticks = stoi(value) != 0;
+    else if (option == "--reduce") options.reduce_interval = stoll(value);
+    else if (option == "--vivify") options.vivify_interval = stoll(value);
+    else if (option == "--vivify-effort") options.vivify_effort = stod(value);
+    else if (option == "--vivify-irredundant") options.vivify_irredundant = stoi(value) != 0;
+    else if (option == "--bce") options.blocked_clause_elimination = stoi(value) != 0;
+    else if (option == "--cce") options.covered_clause_elimination = stoi(value) != 0;
+    else if (option == "--proof") options.proof_path = value;
+    else if (option == "--lrat") options.proof_lrat = stoi(value) != 0;
+    else if (option == "--checkpoint") options.checkpoint_path = value;
+    else if (option == "--checkpoint-interval") options.checkpoint_interval = stod(value);
+    else if (option == "--resume") options.resume_path = value;
+    else if (option == "--hints") options.hint_path = value;
+    else if (option == "--hint-bias") options.hint_bias = stod(value);
+    else return false;
+    return true;
+}
+
+// counters collected during search, reported even if search is cut short
+struct SolverStatistics
+{
+    long long decisions = 0;
+    long long conflicts = 0;
+    long long propagations = 0;
+    long long learned_clauses = 0;
+    long long flips = 0;            // local search only
+    long long eliminated_clauses = 0;  // by preprocessing
+    double seconds = 0;
+    double memory_mb = 0;
+    // a proof was asked for but could not be written (in full): an UNSAT result has no certificate
+    bool proof_write_failed = false;
+};
+
+inline void printSolverStatistics(const SolverStatistics& statistics, ostream& out) {
+    out << "c decisions: " << statistics.decisions << endl;
+    out << "c conflicts: " << statistics.conflicts << endl;
+    out << "c propagations: " << statistics.propagations << endl;
+    out << "c learned clauses: " << statistics.learned_clauses << endl;
+    if (statistics.flips > 0) out << "c flips: " << statistics.flips << endl;
+    if (statistics.eliminated_clauses > 0) out << "c eliminated clauses: " << statistics.eliminated_clauses << endl;
+    out << "c seconds: " << statistics.seconds << endl;
+    out << "c memory MB: " << statistics.memory_mb << endl;
+}
+
+// set from the SIGINT handler; only ever written with a sig_atomic_t store
+static volatile sig_atomic_t interrupt_signalled = 0;
+
+inline void handleInterruptSignal(int) {
+    interrupt_signalled = 1;
+}
+
+/* Literals are packed as 2 * variable + sign, with variables indexed from 0
+ * and the low bit set for negative literals, so a literal can index arrays
+ * directly and its negation is a single xor.
+ * DIMACS ints are only converted in readDimacs() and printResult().
+*/
+typedef unsigned int Lit;
+
+// values stored in literal_values
+const signed char LIT_FALSE = 0;
+const signed char LIT_TRUE = 1;
+const signed char LIT_UNASSIGNED = -1;
+
+inline Lit makeLiteral(int variable, bool is_negative) {
+    return ((Lit) variable << 1) | (Lit) is_negative;
+}
+
+inline Lit negateLiteral(Lit literal) {
+    return literal ^ 1;
+}
+
+inline int literalVariable(Lit literal) {
+    return (int) (literal >> 1);
+}
+
+inline bool isNegativeLiteral(Lit literal) {
+    return literal & 1;
+}
+
+// convert 1-indexed signed DIMACS literal to packed literal
+inline Lit fromDimacs(int dimacs_literal) {
+    return makeLiteral(abs(dimacs_literal) - 1, dimacs_literal < 0);
+}
+
+// convert packed literal back to 1-indexed signed DIMACS literal
+inline int toDimacs(Lit literal) {
+    int variable = literalVariable(literal) + 1;
+    return isNegativeLiteral(literal) ? -variable : variable;
+}
+
+/* a CNF as read from DIMACS, before any engine builds its own structures.
+ * Clause i is literals[clause_start[i] .. clause_start[i + 1]).
+*/
+struct CNFFormula
+{
+    int num_variables = 0;
+    vector<Lit> literals;
+    vector<int> clause_start = vector<int>(1, 0);
+
+    int numClauses() const {
+        return clause_start.size() - 1;
+    }
+
+    int clauseSize(int clause) const {
+        return clause_start[clause + 1] - clause_start[clause];
+    }
+
+    const Lit* clauseLiterals(int clause) const {
+        return literals.data() + clause_start[clause];
+    }
+
+    void clear() {
+        num_variables = 0;
+        literals.clear();
+        clause_start.assign(1, 0);
+    }
+
+    void addClause(const vector<Lit>& clause) {
+        literals.insert(literals.end(), clause.begin(), clause.end());
+        clause_start.push_back(literals.size());
+    }
+};
+
+// parse a DIMACS CNF: comment lines, the "p cnf <variables> <clauses>" line, then the clauses
+inline void readDimacs(istream& in, CNFFormula& formula) {
+    char c;
+    string s;
+    int num_clauses = 0;
+    formula.clear();
+    // ignore comments
+    while (in >> c) {
+        if (c == 'c') {
+            getline(in, s);            
+        } else {
+            // should be == 'p'
+            break;
+        }
+    }
+    in >> s;
+    in >> formula.num_variables;
+    in >> num_clauses;
+
+    int literal;
+    for (int i = 0; i < num_clauses; i++) {
+        while (in >> literal && literal != 0) {
+            formula.literals.push_back(fromDimacs(literal));
+        }
+        // end of claused reached
+        formula.clause_start.push_back(formula.literals.size());
+    }
+}
+
+/* readDimacs for input that cannot be trusted: false, with the reason in
+ * failure, for a missing or malformed "p cnf" line, more than max_variables
+ * variables, a literal beyond the declared variables, a clause count other
+ * than the declared one or input ending inside a clause. Comment lines may
+ * appear anywhere, and a "%" line (as SATLIB files end) ends the input.
+*/
+inline bool readDimacsChecked(istream& in, CNFFormula& formula, int max_variables, string& failure) {
+    formula.clear();
+    string token;
+    while (in >> token && token[0] == 'c') getline(in, token);
+    long long num_variables = -1, num_clauses = -1;
+    string format;
+    if (!in || token != "p" || !(in >> format) || format != "cnf" || !(in >> num_variables >> num_clauses)
+        || num_variables < 0 || num_clauses < 0) {
+        failure = "missing or malformed p cnf line";
+        return false;
+    }
+    if (num_variables > max_variables) {
+        failure = to_string(num_variables) + " variables, more than the " + to_string(max_variables) + " allowed";
+        return false;
+    }
+    formula.num_variables = num_variables;
+
+    long long clauses_read = 0;
+    bool is_in_clause = false;
+    while (in >> token) {
+        if (token[0] == 'c') {
+            getline(in, token);
+            continue;
+        }
+        if (token[0] == '%') break;
+        char* end;
+        long literal = strtol(token.c_str(), &end, 10);
+        if (*end != 0) {
+            failure = "bad literal " + token;
+            return false;
+        }
+        if (literal == 0) {
+            if (++clauses_read > num_clauses) {
+                failure = "more clauses than the " + to_string(num_clauses) + " declared";
+                return false;
+            }
+            formula.clause_start.push_back(formula.literals.size());
+            is_in_clause = false;
+            continue;
+        }
+        if (labs(literal) > num_variables) {
+            failure = "literal " + token + " beyond the " + to_string(num_variables) + " declared variables";
+            return false;
+        }
+        formula.literals.push_back(fromDimacs(literal));
+        is_in_clause = true;
+    }
+    if (is_in_clause) {
+        failure = "input ends inside a clause";
+        return false;
+    }
+    if (clauses_read != num_clauses) {
+        failure = to_string(clauses_read) + " clauses, " + to_string(num_clauses) + " declared";
+        return false;
+    }
+    return true;
+}
+
+// write a formula as DIMACS CNF, the inverse of readDimacs
+inline void writeDimacs(ostream& out, const CNFFormula& formula) {
+    out << "p cnf " << formula.num_variables << " " << formula.numClauses() << "\n";
+    for (int c = 0; c < formula.numClauses(); c++) {
+        const Lit* literals = formula.clauseLiterals(c);
+        for (int k = 0; k < formula.clauseSize(c); k++) out << toDimacs(literals[k]) << " ";
+        out << "0\n";
+    }
+    out << flush;
+}
+
+/* read assignment hints: DIMACS literals separated by whitespace, e.g. a model
+ * from an earlier run. Comment lines, words ("SAT", "v") and values outside
+ * the formula's variables are skipped, so an earlier run's output can be
+ * passed as is.
+*/
+inline bool readHints(const string& path, int num_variables, vector<Lit>& hints) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "cannot read hints " << path << endl;
+        return false;
+    }
+    hints.clear();
+    string token;
+    while (in >> token) {
+        if (token[0] == 'c') {
+            getline(in, token);
+            continue;
+        }
+        char* end;
+        long value = strtol(token.c_str(), &end, 10);
+        if (*end != 0 || value == 0 || labs(value) > num_variables) continue;
+        hints.push_back(fromDimacs(value));
+    }
+    return true;
+}
+
+/* xoshiro256** generator: small, fast and seedable, so every solver owns one
+ * and runs are reproducible per seed, independent of other threads.
+*/
+struct Xoshiro256
+{
+    uint64_t state[4];
+
+    explicit Xoshiro256(uint64_t seed = 0) {
+        setSeed(seed);
+    }
+
+    // expand the seed with splitmix64 so nearby seeds give unrelated streams
+    void setSeed(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    static uint64_t rotateLeft(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t next() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    // uniform in [0, bound) by multiply-shift, no division
+    uint32_t below(uint32_t bound) {
+        return (uint32_t) (((next() >> 32) * bound) >> 32);
+    }
+
+    // uniform in [0, 1)
+    double nextDouble() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+/* interface the drivers use to run any solver engine.
+ * Engines implement it once, at the top level, so choosing an engine by
+ * name costs one virtual call per solve, never one per decision.
+*/
+class SatSolver
+{
+public:
+    virtual ~SatSolver() {}
+
+    // intiailize solver state from a parsed formula
+    virtual void load(const CNFFormula& formula) = 0;
+    /* drops the loaded formula but keeps allocated memory for the next load(),
+     * which resets by itself anyway; engines that do not pool memory ignore it
+    */
+    virtual void reset() {}
+    // search without printing anything
+    virtual ReturnValue search() = 0;
+    virtual int numVariables() = 0;
+    // value of a 0-indexed variable in the model found by a SAT search()
+    virtual bool modelValue(int variable) = 0;
+    // suggest a polarity for decisions on a variable; engines without phases ignore it
+    virtual void suggestPhase(int variable, bool is_negative) {}
+    /* suggest a partial or complete assignment, e.g. a model of a similar
+     * formula; call after load(). By default it only suggests phases
+    */
+    virtual void suggestAssignment(const vector<Lit>& literals) {
+        for (int i = 0; i < literals.size(); i++) suggestPhase(literalVariable(literals[i]), isNegativeLiteral(literals[i]));
+    }
+    virtual void setBudget(const SolverBudget& new_budget) = 0;
+    virtual void setOptions(const SolverOptions& new_options) {}
+    // seeds any randomized choices; call before init()
+    virtual void setSeed(uint64_t seed) = 0;
+    // asks a running search() to stop at the next check; safe to call from any thread
+    virtual void interrupt() = 0;
+    virtual const SolverStatistics& getStatistics() = 0;
+
+    /* intiailize class state from cin input.
+     * 
+    */
+    void init() {
+        CNFFormula formula;
+        readDimacs(cin, formula);
+        load(formula);
+    }
+
+    ReturnValue solve(bool printSATliterals) {
+        ReturnValue result = search();
+        printResult(result, printSATliterals);
+        return result;
+    }
+
+    void printResult(ReturnValue result, bool printSATliterals, ostream& out = cout) {
+        if (result == ReturnValue::sat) {
+            out << "SAT" << endl;
+            if (printSATliterals) {
+                for (int i = 0; i < numVariables(); i++) {
+                    // for variables that are assigned true, print as true;
+                    // for unassigned variables (which at this stage can take any value), print as false 
+                    out << toDimacs(makeLiteral(i, !modelValue(i))) << " ";
+                }
+                out << "0" << endl;
+            }
+        } else if (result == ReturnValue::unknown) {
+            // budget exhausted or interrupted: report how far we got
+            out << "UNKNOWN" << endl;
+            printStatistics(out);
+        } else {
+            // print UNSAT
+            out << "UNSAT" << endl;
+        }
+    }
+
+    void printStatistics(ostream& out) { printSolverStatistics(getStatistics(), out); }
+};
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef SOLVER_DRIVERS_H
+#define SOLVER_DRIVERS_H
+
+#include "SolverRegistry.h"
+#include "ProofChecker.h"
+#include "SolverServer.h"
+#include "Autotuner.h"
+#include "InstanceGenerator.h"
+#include "ResultCache.h"
+
+// main() bodies shared by the Solver*.cpp executables, which differ only in their defaults
+
+/* check mode: "check PROOF [--lrat FILE]" verifies a DRAT proof (binary or text)
+ * of the CNF read from stdin, and with --lrat writes the trimmed proof as binary LRAT
+*/
+inline int runProofCheck(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: check PROOF [--lrat FILE] < CNF" << endl;
+        return 1;
+    }
+    string lrat_path;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--lrat") lrat_path = argv[i + 1];
+        else cerr << "ignoring unknown option " << option << endl;
+    }
+    ifstream proof_file(argv[2], ios::binary);
+    if (!proof_file) {
+        cerr << "cannot read proof " << argv[2] << endl;
+        return 1;
+    }
+    vector<char> proof((istreambuf_iterator<char>(proof_file)), istreambuf_iterator<char>());
+    CNFFormula formula;
+    readDimacs(cin, formula);
+
+    auto start = chrono::steady_clock::now();
+    DratChecker checker;
+    bool is_verified = checker.verify(formula, proof);
+    cout << (is_verified ? "VERIFIED" : "NOT VERIFIED") << endl;
+    if (!is_verified) cout << "c " << checker.failure << endl;
+    cout << "c lemmas: " << checker.num_lemmas << endl;
+    cout << "c core lemmas: " << checker.num_core_lemmas << endl;
+    if (checker.num_rat_lemmas > 0) cout << "c RAT lemmas: " << checker.num_rat_lemmas << endl;
+    if (checker.num_ignored_deletions > 0) cout << "c ignored deletions: " << checker.num_ignored_deletions << endl;
+    bool is_lrat_written = true;
+    if (is_verified && !lrat_path.empty() && !checker.writeLrat(lrat_path)) {
+        cerr << "cannot write LRAT proof to " << lrat_path << endl;
+        is_lrat_written = false;
+    }
+    cout << "c seconds: " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << endl;
+    return is_verified && is_lrat_written ? 0 : 1;
+}
+
+/* features mode: "features [--selector FILE] < CNF" prints the features of the
+ * CNF and the engine "auto" (or "auto:FILE") would pick, as a selector model
+ * line: swap in the engine that actually solved it best to grow a model file
+*/
+inline int runFeatureExtraction(int argc, char* argv[]) {
+    string model_path;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--selector") model_path = argv[i + 1];
+        else cerr << "ignoring unknown option " << option << endl;
+    }
+    unique_ptr<EngineSelector> selector(new RuleSelector());
+    if (!model_path.empty()) {
+        unique_ptr<NearestNeighbourSelector> model(new NearestNeighbourSelector());
+        if (!model->load(model_path)) return 1;
+        selector = move(model);
+    }
+    CNFFormula formula;
+    readDimacs(cin, formula);
+
+    auto start = chrono::steady_clock::now();
+    FeatureExtractor extractor;
+    InstanceFeatures features = extractor.extract(formula);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const vector<string>& names = InstanceFeatures::names();
+    cout << "c engine";
+    for (int i = 0; i < names.size(); i++) cout << " " << names[i];
+    cout << endl;
+    vector<double> values = features.values();
+    cout << selector->select(features);
+    for (int i = 0; i < values.size(); i++) cout << " " << values[i];
+    cout << endl;
+    cout << "c seconds: " << seconds << endl;
+    return 0;
+}
+
+/* solve one CNF read from stdin. A first argument of "check", "serve", "client",
+ * "features", "tune", "generate" or "scale" runs runProofCheck(), runServer(),
+ * runClient(), runFeatureExtraction(), runTuner(), runGenerator() or
+ * runScalingBenchmark() instead.
+ * options: --heuristic NAME (--list prints the names, "auto" picks one per formula), --seed N,
+ * budgets --conflicts N --propagations N --time SECONDS --memory MB --flips N
+ * (local search counts flips against --flips and --propagations, brute force blocks of
+ * assignments against --propagations; neither has conflicts),
+ * search options --chrono N (chronological backtracking above N levels),
+ * --modes N (conflicts in the first focused mode, -1 never switches),
+ * --mode-ticks 0|1 (measure later modes in conflicts or propagation ticks),
+ * --reduce N (conflicts before learned clauses are first reduced, -1 keeps all),
+ * --vivify N (conflicts between vivification rounds, -1 never vivifies),
+ * --vivify-effort F (fraction of search ticks a round may use),
+ * --vivify-irredundant 0|1 (also vivify input clauses),
+ * --bce 0|1 (blocked clause elimination before search), --cce 0|1 (covered clauses too),
+ * --proof FILE (binary DRAT proof of UNSAT results), --lrat 0|1 (binary LRAT instead),
+ * --config FILE (the settings of a configuration file, as "tune" writes them),
+ * --checkpoint FILE (snapshot the search there every --checkpoint-interval S
+ * seconds and when it stops unfinished), --resume FILE (continue from such a snapshot),
+ * --hints FILE (an assignment to try first, e.g. the output of a run on a similar
+ * formula), --hint-bias F (raise the hinted variables' scores by F times the highest),
+ * --cache FILE (answer a formula found in this on-disk result cache without
+ * solving it, and add the result otherwise)
+*/
+inline int runSingleInstance(int argc, char* argv[], string heuristic) {
+    SolverBudget budget;
+    SolverOptions options;
+    uint64_t seed = 0;
+    string cache_path;
+    if (argc > 1 && string(argv[1]) == "check") return runProofCheck(argc, argv);
+    if (argc > 1 && string(argv[1]) == "serve") return runServer(argc, argv, heuristic);
+    if (argc > 1 && string(argv[1]) == "client") return runClient(argc, argv);
+    if (argc > 1 && string(argv[1]) == "features") return runFeatureExtraction(argc, argv);
+    if (argc > 1 && string(argv[1]) == "tune") return runTuner(argc, argv);
+    if (argc > 1 && string(argv[1]) == "generate") return runGenerator(argc, argv);
+    if (argc > 1 && string(argv[1]) == "scale") return runScalingBenchmark(argc, argv, heuristic);
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--list") {
+            printSolverNames(cout);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cerr << "missing value for " << option << endl;
+            return 1;
+        }
+        i++;
+        if (option == "--heuristic") heuristic = argv[i];
+        else if (option == "--seed") seed = stoull(argv[i]);
+        else if (option == "--cache") cache_path = argv[i];
+        else if (option == "--config") {
+            Configuration configuration;
+            if (!configuration.read(argv[i])) {
+                cerr << "cannot read configuration " << argv[i] << endl;
+                return 1;
+            }
+            if (!configuration.apply(heuristic, budget, options)) cerr << "ignoring unknown options in " << argv[i] << endl;
+        } else if (!parseSolveOption(option, argv[i], budget, options)) cerr << "ignoring unknown option " << option << endl;
+    }
+    unique_ptr<SatSolver> solver = createSolver(heuristic);
+    if (!solver) {
+        cerr << "unknown heuristic " << heuristic << ", choose one of:" << endl;
+        printSolverNames(cerr);
+        return 1;
+    }
+    // Ctrl-C ends the search with UNKNOWN instead of killing the process;
+    // so does SIGTERM, which batch schedulers send before preempting a job
+    signal(SIGINT, handleInterruptSignal);
+    signal(SIGTERM, handleInterruptSignal);
+
+    // open file
+    ofstream timefile;
+    timefile.open ("time2.txt");
+
+    // options first: some of them (LRAT ids) already matter while loading
+    solver->setSeed(seed);
+    solver->setBudget(budget);
+    solver->setOptions(options);
+    CNFFormula formula;
+    readDimacs(cin, formula);
+    // a formula an earlier run answered is not even loaded; a proof always needs a search
+    ResultCache cache(0);
+    bool use_cache = !cache_path.empty() && options.proof_path.empty() && cache.openIndex(cache_path);
+    CacheKey key = use_cache ? canonicalFormulaKey(formula) : CacheKey();
+    CachedResult cached;
+    bool has_proof_failed = false;
+
+    // measure time start
+    clock_t t;
+	t = clock();
+
+    bool is_cached = use_cache && cache.lookup(key, formula, cached);
+    if (is_cached) {
+        printCachedResult(cached, true, cout);
+        cerr << "c cached result" << endl;
+    } else {
+        solver->load(formula);
+        vector<Lit> hints;
+        if (!options.hint_path.empty() && readHints(options.hint_path, solver->numVariables(), hints)) solver->suggestAssignment(hints);
+        t = clock();
+        ReturnValue result = solver->solve(true);
+        if (use_cache) cache.store(key, makeCachedResult(*solver, result));
+        has_proof_failed = solver->getStatistics().proof_write_failed;
+        if (has_proof_failed) cout << "c proof write failed" << endl;
+    }
+    // measure time end
+	clock_t timeTaken = clock() - t;
+	// cout << "time: " << t << " miliseconds" << endl;
+	// cout << CLOCKS_PER_SEC << " clocks per second" << endl;
+	// cout << "time: " << t*1.0/CLOCKS_PER_SEC << " seconds" << endl;
+
+    // double dif = difftime (end,start);
+    cout << timeTaken << endl;
+    timefile << timeTaken << "\n";
+    
+    timefile.close();
+    // an UNSAT answer without its proof must not pass for a certified one
+    return has_proof_failed ? 1 : 0;
+}
+
+// settings of a batch run over numbered files <inputfiledir><inputfileprefix>-0<n>.cnf
+struct BatchParams
+{
+    int startfileno = 1;
+    int endfileno = 30;                                // must be less than 100 otherwise formatting issues
+    bool printSATliterals = false;
+    string heuristic = "frequency-none-polarity";
+    string inputfiledir = "testcase-sat75/";
+    string inputfileprefix = "uf75";
+    // instance n of the batch is solved with seed + n
+    uint64_t seed = 0;
+    // per-instance limits so one hard file cannot stall the whole batch (-1 = unlimited)
+    SolverBudget budget;
+    SolverOptions options;
+    // results kept in memory, so a file repeating an earlier one is not solved again (0 keeps none)
+    size_t cache_entries = DEFAULT_CACHE_ENTRIES;
+    // on-disk result cache shared with other runs; empty uses none
+    string cache_path;
+};
+
+inline int runBatch(const BatchParams& params) {
+    // Ctrl-C stops the current instance with UNKNOWN and ends the batch
+    signal(SIGINT, handleInterruptSignal);
+
+    // one solver and one parsed formula serve every file: reset() drops the
+    // previous instance but keeps the memory, so warm instances barely allocate
+    unique_ptr<SatSolver> solver = createSolver(params.heuristic);
+    if (!solver) {
+        cerr << "unknown heuristic " << params.heuristic << endl;
+        return 1;
+    }
+    solver->setBudget(params.budget);
+    solver->setOptions(params.options);
+    CNFFormula formula;
+    ResultCache cache(params.cache_entries);
+    if (!params.cache_path.empty()) cache.openIndex(params.cache_path);
+    bool use_cache = cache.isEnabled() && params.options.proof_path.empty();
+    CachedResult cached;
+    bool has_proof_failed = false;
+
+    // open outputfile
+    ofstream timefile;
+    timefile.open ("time.txt");
+    
+    for (int fileno = params.startfileno; fileno <= params.endfileno; fileno++) {
+
+        // open input file
+        string inputfile = params.inputfileprefix + "-0" + to_string(fileno) + ".cnf";
+        string fulldir = params.inputfiledir + inputfile;
+        std::ifstream in(fulldir);
+        readDimacs(in, formula);
+        CacheKey key = use_cache ? canonicalFormulaKey(formula) : CacheKey();
+
+        // measure time start
+        clock_t t;
+        t = clock();
+
+        if (use_cache && cache.lookup(key, formula, cached)) {
+            printCachedResult(cached, params.printSATliterals, cout);
+        } else {
+            solver->setSeed(params.seed + fileno);
+            solver->reset();
+            solver->load(formula);
+            t = clock();
+            ReturnValue result = solver->solve(params.printSATliterals);
+            if (use_cache) cache.store(key, makeCachedResult(*solver, result));
+            if (solver->getStatistics().proof_write_failed) {
+                cout << "c proof write failed" << endl;
+                has_proof_failed = true;
+            }
+        }
+        // measure time end
+        clock_t timeTaken = clock() - t;
+        // cout << "time: " << t << " miliseconds" << endl;
+        // cout << CLOCKS_PER_SEC << " clocks per second" << endl;
+        // cout << "time: " << t*1.0/CLOCKS_PER_SEC << " seconds" << endl;
+
+        // double dif = difftime (end,start);
+        cout << timeTaken << endl;
+        timefile << timeTaken << "\n";
+
+        if (interrupt_signalled) break;
+    }
+    timefile.close();
+
+    return has_proof_failed ? 1 : 0;
+}
+
+#endif
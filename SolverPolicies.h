@@ -0,0 +1,894 @@
+#ifndef SOLVER_POLICIES_H
+#define SOLVER_POLICIES_H
+
+#include "SolverCommon.h"
+
+/* Policies plugged into CDCLSolver. Each one is a plain class whose methods
+ * are called directly from the search loop, so they must be cheap.
+ *
+ * The solver alternates between a focused mode (frequent restarts, fast
+ * moving scores) and a stable mode (rare restarts, target phases) when
+ * any of its policies declares has_modes; setStableMode tells every policy
+ * which mode it is in, and a policy with two modes keeps separate state for each.
+ *
+ * Branching policy:
+ *   static const char* name();
+ *   static const bool has_modes;
+ *   void init(const vector<int>& variable_occurrences, uint64_t seed);
+ *   void setStableMode(bool stable);
+ *   void onAssign(int variable);
+ *   void onUnassign(int variable);
+ *   void onConflictVariable(int variable);   // each variable met in conflict analysis, before onLearnedClause
+ *   void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values);
+ *   void onRestart();
+ *   int pickVariable(const vector<signed char>& literal_values, int num_unassigned);
+ *   void exportScores(vector<double>& scores);        // per variable, for snapshots; higher is picked first
+ *   void importScores(const vector<double>& scores);  // after init(), from a snapshot of the same policy
+ *
+ * Restart policy:
+ *   static const char* name();
+ *   static const bool has_modes;
+ *   void init();
+ *   void setStableMode(bool stable);
+ *   void onLearnedClause(int lbd);   // lbd: number of decision levels in the clause
+ *   bool shouldRestart(long long num_conflicts);
+ *
+ * Phase policy:
+ *   static const char* name();
+ *   static const bool has_modes;
+ *   void init(int num_variables);
+ *   void setStableMode(bool stable);
+ *   void onUnassign(int variable, bool was_negative);
+ *   void onConflict(const vector<Lit>& trail, int conflict_free_size);  // trail[0 .. conflict_free_size) led to no conflict
+ *   void setPhase(int variable, bool is_negative);   // external suggestion, e.g. from local search
+ *   bool pickNegative(int variable, const vector<int>& literal_polarity_difference);
+*/
+
+// -------------------------
+// Branching policies
+// -------------------------
+
+// picks the unassigned variable occurring in the most clauses (input and learned)
+struct FrequencyBranching
+{
+    // to be used for variable picking, -1 while assigned
+    vector<int> variable_frequency;
+
+    // to be used for resetting
+    vector<int> initial_variable_frequency;
+
+    static const char* name() { return "frequency"; }
+    static const bool has_modes = false;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        variable_frequency = variable_occurrences;
+        initial_variable_frequency = variable_occurrences;
+    }
+
+    void setStableMode(bool stable) {}
+
+    void onAssign(int variable) {
+        variable_frequency[variable] = -1;
+    }
+
+    void onUnassign(int variable) {
+        variable_frequency[variable] = initial_variable_frequency[variable];
+    }
+
+    void onConflictVariable(int variable) {}
+    void onRestart() {}
+
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {
+        for (int i = 0; i < clause.size(); i++) {
+            int variable = literalVariable(clause[i]);
+            initial_variable_frequency[variable]++;
+            // if variable has not been assigned, update current frequency
+            if (literal_values[clause[i]] == LIT_UNASSIGNED) {
+                variable_frequency[variable]++;
+            }
+        }
+    }
+
+    // currently just picks variable with highest frequency
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        // start below 0 so variables that occur nowhere can still be picked
+        int max_frequency = -1;
+        int max_frequency_variable = -1;
+        for (int i = 0; i < variable_frequency.size(); i++) {
+            if (variable_frequency[i] > max_frequency) {
+                max_frequency = variable_frequency[i];
+                max_frequency_variable = i;
+            }
+        }
+        return max_frequency_variable;
+    }
+
+    void exportScores(vector<double>& scores) {
+        scores.assign(initial_variable_frequency.begin(), initial_variable_frequency.end());
+    }
+
+    // imported before search, while every variable is unassigned
+    void importScores(const vector<double>& scores) {
+        for (int v = 0; v < scores.size(); v++) initial_variable_frequency[v] = (int) scores[v];
+        variable_frequency = initial_variable_frequency;
+    }
+};
+
+/* chooses an unassigned variable uniformly at random.
+ * The unassigned variables are kept as a sparse set (a dense array plus each
+ * variable's position in it), so picking, removing on assignment and
+ * reinserting on backtrack are all O(1).
+*/
+struct RandomBranching
+{
+    vector<int> unassigned_variables;
+    // index of each variable in unassigned_variables, -1 while assigned
+    vector<int> unassigned_position;
+    Xoshiro256 generator;
+
+    static const char* name() { return "random"; }
+    static const bool has_modes = false;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        int num_variables = variable_occurrences.size();
+        unassigned_variables.resize(num_variables);
+        unassigned_position.resize(num_variables);
+        for (int i = 0; i < num_variables; i++) {
+            unassigned_variables[i] = i;
+            unassigned_position[i] = i;
+        }
+        generator.setSeed(seed);
+    }
+
+    void setStableMode(bool stable) {}
+
+    // move the last entry into the removed variable's slot
+    void onAssign(int variable) {
+        int position = unassigned_position[variable];
+        int last_variable = unassigned_variables.back();
+        unassigned_variables[position] = last_variable;
+        unassigned_position[last_variable] = position;
+        unassigned_variables.pop_back();
+        unassigned_position[variable] = -1;
+    }
+
+    void onUnassign(int variable) {
+        unassigned_position[variable] = unassigned_variables.size();
+        unassigned_variables.push_back(variable);
+    }
+
+    void onConflictVariable(int variable) {}
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {}
+    void onRestart() {}
+
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        return unassigned_variables[generator.below(unassigned_variables.size())];
+    }
+
+    // random picks have no scores to carry over
+    void exportScores(vector<double>& scores) { scores.assign(unassigned_position.size(), 0); }
+    void importScores(const vector<double>& scores) {}
+};
+
+/* binary max-heap of variables ordered by an external score table.
+ * heap_position[v] is v's index in heap, or -1 when v is not in it.
+ * A suspended heap ignores all updates until the next build(), so a
+ * heuristic that is not being used can keep its scores without paying
+ * for the heap.
+*/
+struct VariableHeap
+{
+    vector<int> heap;
+    vector<int> heap_position;
+    const vector<double>* score = nullptr;
+    bool suspended = false;
+
+    bool contains(int variable) const { return heap_position[variable] != -1; }
+    bool empty() const { return heap.empty(); }
+    int top() const { return heap[0]; }
+
+    void moveUp(int index) {
+        int variable = heap[index];
+        while (index > 0) {
+            int parent = (index - 1) / 2;
+            if ((*score)[heap[parent]] >= (*score)[variable]) break;
+            heap[index] = heap[parent];
+            heap_position[heap[index]] = index;
+            index = parent;
+        }
+        heap[index] = variable;
+        heap_position[variable] = index;
+    }
+
+    void moveDown(int index) {
+        int variable = heap[index];
+        while (true) {
+            int child = 2 * index + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && (*score)[heap[child + 1]] > (*score)[heap[child]]) child++;
+            if ((*score)[heap[child]] <= (*score)[variable]) break;
+            heap[index] = heap[child];
+            heap_position[heap[index]] = index;
+            index = child;
+        }
+        heap[index] = variable;
+        heap_position[variable] = index;
+    }
+
+    void insert(int variable) {
+        if (suspended) return;
+        heap_position[variable] = heap.size();
+        heap.push_back(variable);
+        moveUp(heap.size() - 1);
+    }
+
+    void removeTop() {
+        int variable = heap[0];
+        heap_position[variable] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (heap.empty()) return;
+        heap[0] = last;
+        heap_position[last] = 0;
+        moveDown(0);
+    }
+
+    // call after the score of a variable in the heap went up
+    void increased(int variable) {
+        if (!suspended && contains(variable)) moveUp(heap_position[variable]);
+    }
+
+    // call after the score of a variable in the heap changed either way
+    void changed(int variable) {
+        if (suspended || !contains(variable)) return;
+        moveUp(heap_position[variable]);
+        moveDown(heap_position[variable]);
+    }
+
+    void suspend() {
+        suspended = true;
+        heap.clear();
+        fill(heap_position.begin(), heap_position.end(), -1);
+    }
+
+    // rebuild over all variables with a new score table
+    void build(const vector<double>& new_score) {
+        suspended = false;
+        score = &new_score;
+        int num_variables = new_score.size();
+        heap.resize(num_variables);
+        heap_position.resize(num_variables);
+        for (int v = 0; v < num_variables; v++) {
+            heap[v] = v;
+            heap_position[v] = v;
+        }
+        for (int i = num_variables / 2 - 1; i >= 0; i--) moveDown(i);
+    }
+};
+
+/* exponential VSIDS: the variables of each learned clause get their activity
+ * raised by an increment that itself grows after every conflict, so older
+ * bumps fade geometrically. Focused mode decays fast, stable mode slowly, and
+ * each mode has its own activity table.
+*/
+struct VSIDSBranching
+{
+    vector<double> focused_activity;
+    vector<double> stable_activity;
+    double focused_increment;
+    double stable_increment;
+    bool stable;
+    // unassigned variables, plus assigned ones not yet popped
+    VariableHeap heap;
+
+    static const char* name() { return "vsids"; }
+    static const bool has_modes = true;
+    static constexpr double FOCUSED_DECAY = 0.95;
+    static constexpr double STABLE_DECAY = 0.999;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        // occurrence counts only break ties until the first few conflicts
+        focused_activity.resize(variable_occurrences.size());
+        for (int v = 0; v < variable_occurrences.size(); v++) {
+            focused_activity[v] = variable_occurrences[v] * 1e-3;
+        }
+        stable_activity = focused_activity;
+        focused_increment = 1;
+        stable_increment = 1;
+        stable = false;
+        heap.build(focused_activity);
+    }
+
+    void setStableMode(bool stable_mode) {
+        stable = stable_mode;
+        if (!heap.suspended) heap.build(stable ? stable_activity : focused_activity);
+    }
+
+    void suspendHeap() { heap.suspend(); }
+    void resumeHeap() { heap.build(stable ? stable_activity : focused_activity); }
+
+    void onAssign(int variable) {}
+
+    void onUnassign(int variable) {
+        if (!heap.contains(variable)) heap.insert(variable);
+    }
+
+    void onConflictVariable(int variable) {}
+    void onRestart() {}
+
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {
+        vector<double>& activity = stable ? stable_activity : focused_activity;
+        double& increment = stable ? stable_increment : focused_increment;
+        for (int i = 0; i < clause.size(); i++) {
+            int variable = literalVariable(clause[i]);
+            activity[variable] += increment;
+            heap.increased(variable);
+            if (activity[variable] > 1e100) {
+                // rescaling keeps the order, so the heap stays valid
+                for (int v = 0; v < activity.size(); v++) activity[v] *= 1e-100;
+                increment *= 1e-100;
+            }
+        }
+        increment /= stable ? STABLE_DECAY : FOCUSED_DECAY;
+    }
+
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        while (literal_values[makeLiteral(heap.top(), false)] != LIT_UNASSIGNED) heap.removeTop();
+        int variable = heap.top();
+        heap.removeTop();
+        return variable;
+    }
+
+    // activities of the current mode in units of its increment, so an import with increment 1 weighs them the same
+    void exportScores(vector<double>& scores) {
+        const vector<double>& activity = stable ? stable_activity : focused_activity;
+        double increment = stable ? stable_increment : focused_increment;
+        scores.resize(activity.size());
+        for (int v = 0; v < activity.size(); v++) scores[v] = activity[v] / increment;
+    }
+
+    void importScores(const vector<double>& scores) {
+        focused_activity = scores;
+        stable_activity = scores;
+        focused_increment = 1;
+        stable_increment = 1;
+        if (!heap.suspended) heap.build(stable ? stable_activity : focused_activity);
+    }
+};
+
+// step size of the learning-rate heuristics: starts at 0.4, minus 1e-6 per conflict, down to 0.06
+struct LearningStepSize
+{
+    double value = 0.4;
+
+    void onConflict() {
+        if (value > 0.06) value -= 1e-6;
+    }
+};
+
+/* learning-rate based branching (LRB): while a variable is assigned, count the
+ * conflicts it takes part in; when it is unassigned, the fraction of conflicts
+ * during its assignment it took part in is its reward, and its score is an
+ * exponential moving average of those rewards.
+ * With the locality extension, scores of unassigned variables also decay by
+ * 0.95 per conflict. That is done lazily, VSIDS style: scores are stored
+ * multiplied by locality_scale, which grows by 1 / 0.95 per conflict.
+*/
+struct LRBBranching
+{
+    // stored (scaled) scores, the heap key
+    vector<double> score;
+    // unscaled score when the variable was assigned; it does not decay while assigned
+    vector<double> assigned_score;
+    double locality_scale;
+    // number of conflicts when the variable was assigned, and conflicts it took part in since
+    vector<long long> assigned_at;
+    vector<int> participated;
+    long long num_conflicts;
+    LearningStepSize step_size;
+    VariableHeap heap;
+
+    static constexpr double LOCALITY_DECAY = 0.95;
+
+    static const char* name() { return "lrb"; }
+    static const bool has_modes = false;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        int num_variables = variable_occurrences.size();
+        // occurrence counts only order the first decisions
+        score.resize(num_variables);
+        for (int v = 0; v < num_variables; v++) score[v] = variable_occurrences[v] * 1e-6;
+        assigned_score = score;
+        locality_scale = 1;
+        assigned_at.assign(num_variables, 0);
+        participated.assign(num_variables, 0);
+        num_conflicts = 0;
+        step_size = LearningStepSize();
+        heap.build(score);
+    }
+
+    void setStableMode(bool stable) {}
+
+    void onAssign(int variable) {
+        assigned_at[variable] = num_conflicts;
+        participated[variable] = 0;
+        assigned_score[variable] = score[variable] / locality_scale;
+    }
+
+    void onUnassign(int variable) {
+        double unscaled = assigned_score[variable];
+        long long interval = num_conflicts - assigned_at[variable];
+        if (interval > 0) {
+            double reward = (double) participated[variable] / interval;
+            unscaled = (1 - step_size.value) * unscaled + step_size.value * reward;
+        }
+        score[variable] = unscaled * locality_scale;
+        if (heap.contains(variable)) heap.changed(variable);
+        else heap.insert(variable);
+    }
+
+    void onConflictVariable(int variable) {
+        participated[variable]++;
+    }
+
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {
+        num_conflicts++;
+        step_size.onConflict();
+        locality_scale /= LOCALITY_DECAY;
+        if (locality_scale > 1e100) {
+            // rescaling keeps the order, so the heap stays valid
+            for (int v = 0; v < score.size(); v++) score[v] *= 1e-100;
+            locality_scale *= 1e-100;
+        }
+    }
+
+    void onRestart() {}
+    void suspendHeap() { heap.suspend(); }
+    void resumeHeap() { heap.build(score); }
+
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        while (literal_values[makeLiteral(heap.top(), false)] != LIT_UNASSIGNED) heap.removeTop();
+        int variable = heap.top();
+        heap.removeTop();
+        return variable;
+    }
+
+    // unscaled scores
+    void exportScores(vector<double>& scores) {
+        scores.resize(score.size());
+        for (int v = 0; v < score.size(); v++) scores[v] = score[v] / locality_scale;
+    }
+
+    void importScores(const vector<double>& scores) {
+        score = scores;
+        assigned_score = scores;
+        locality_scale = 1;
+        if (!heap.suspended) heap.build(score);
+    }
+};
+
+/* conflict-history based branching (CHB): every assignment rewards its
+ * variable by how recently the variable took part in a conflict, 1 / (conflicts
+ * since then + 1), discounted to 0.9 for assignments that caused no conflict;
+ * variables in a conflict get the full reward. Scores are exponential moving
+ * averages of the rewards.
+*/
+struct CHBBranching
+{
+    vector<double> score;
+    // conflict number of the last conflict each variable took part in
+    vector<long long> last_conflict;
+    long long num_conflicts;
+    LearningStepSize step_size;
+    VariableHeap heap;
+
+    static const char* name() { return "chb"; }
+    static const bool has_modes = false;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        int num_variables = variable_occurrences.size();
+        score.resize(num_variables);
+        for (int v = 0; v < num_variables; v++) score[v] = variable_occurrences[v] * 1e-6;
+        last_conflict.assign(num_variables, 0);
+        num_conflicts = 0;
+        step_size = LearningStepSize();
+        heap.build(score);
+    }
+
+    void setStableMode(bool stable) {}
+
+    void reward(int variable, double multiplier) {
+        double reward = multiplier / (num_conflicts - last_conflict[variable] + 1);
+        score[variable] = (1 - step_size.value) * score[variable] + step_size.value * reward;
+        heap.changed(variable);
+    }
+
+    void onAssign(int variable) {
+        reward(variable, 0.9);
+    }
+
+    void onUnassign(int variable) {
+        if (!heap.contains(variable)) heap.insert(variable);
+    }
+
+    void onConflictVariable(int variable) {
+        // the conflict being analyzed is number num_conflicts + 1, so the reward is 1 / (0 + 1)
+        last_conflict[variable] = num_conflicts + 1;
+        score[variable] = (1 - step_size.value) * score[variable] + step_size.value;
+        heap.changed(variable);
+    }
+
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {
+        num_conflicts++;
+        step_size.onConflict();
+    }
+
+    void onRestart() {}
+    void suspendHeap() { heap.suspend(); }
+    void resumeHeap() { heap.build(score); }
+
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        while (literal_values[makeLiteral(heap.top(), false)] != LIT_UNASSIGNED) heap.removeTop();
+        int variable = heap.top();
+        heap.removeTop();
+        return variable;
+    }
+
+    void exportScores(vector<double>& scores) { scores = score; }
+
+    void importScores(const vector<double>& scores) {
+        score = scores;
+        if (!heap.suspended) heap.build(score);
+    }
+};
+
+/* picks one of VSIDS, LRB and CHB at every restart with the UCB1 bandit rule.
+ * The reward of a run between two restarts is its conflicts per decision.
+ * All three heuristics see every event, so whichever is picked next has
+ * up-to-date scores; only the one in use maintains its heap.
+*/
+struct BanditBranching
+{
+    static const int NUM_ARMS = 3;
+
+    VSIDSBranching vsids;
+    LRBBranching lrb;
+    CHBBranching chb;
+    int current_arm;
+    // conflicts and decisions since the last restart
+    long long run_conflicts;
+    long long run_decisions;
+    // per arm: number of runs and sum of their rewards
+    long long arm_runs[NUM_ARMS];
+    double arm_reward[NUM_ARMS];
+    long long total_runs;
+
+    static const char* name() { return "bandit"; }
+    static const bool has_modes = false;
+
+    void init(const vector<int>& variable_occurrences, uint64_t seed) {
+        vsids.init(variable_occurrences, seed);
+        lrb.init(variable_occurrences, seed);
+        chb.init(variable_occurrences, seed);
+        current_arm = 0;
+        lrb.suspendHeap();
+        chb.suspendHeap();
+        run_conflicts = 0;
+        run_decisions = 0;
+        for (int arm = 0; arm < NUM_ARMS; arm++) {
+            arm_runs[arm] = 0;
+            arm_reward[arm] = 0;
+        }
+        total_runs = 0;
+    }
+
+    void setStableMode(bool stable) {
+        vsids.setStableMode(stable);
+    }
+
+    void onAssign(int variable) {
+        vsids.onAssign(variable);
+        lrb.onAssign(variable);
+        chb.onAssign(variable);
+    }
+
+    void onUnassign(int variable) {
+        vsids.onUnassign(variable);
+        lrb.onUnassign(variable);
+        chb.onUnassign(variable);
+    }
+
+    void onConflictVariable(int variable) {
+        lrb.onConflictVariable(variable);
+        chb.onConflictVariable(variable);
+    }
+
+    void onLearnedClause(const vector<Lit>& clause, const vector<signed char>& literal_values) {
+        run_conflicts++;
+        vsids.onLearnedClause(clause, literal_values);
+        lrb.onLearnedClause(clause, literal_values);
+        chb.onLearnedClause(clause, literal_values);
+    }
+
+    void suspendArm(int arm) {
+        if (arm == 0) vsids.suspendHeap();
+        else if (arm == 1) lrb.suspendHeap();
+        else chb.suspendHeap();
+    }
+
+    void resumeArm(int arm) {
+        if (arm == 0) vsids.resumeHeap();
+        else if (arm == 1) lrb.resumeHeap();
+        else chb.resumeHeap();
+    }
+
+    // credit the finished run to its arm, then pick the arm with the best upper confidence bound
+    void onRestart() {
+        if (run_decisions == 0) return;
+        arm_runs[current_arm]++;
+        arm_reward[current_arm] += min(1.0, (double) run_conflicts / run_decisions);
+        total_runs++;
+        run_conflicts = 0;
+        run_decisions = 0;
+
+        int next_arm = -1;
+        // every arm is tried once before any is repeated
+        for (int arm = 0; arm < NUM_ARMS && next_arm == -1; arm++) {
+            if (arm_runs[arm] == 0) next_arm = arm;
+        }
+        if (next_arm == -1) {
+            double best_bound = -1;
+            for (int arm = 0; arm < NUM_ARMS; arm++) {
+                double bound = arm_reward[arm] / arm_runs[arm] + sqrt(2 * log((double) total_runs) / arm_runs[arm]);
+                if (bound > best_bound) {
+                    best_bound = bound;
+                    next_arm = arm;
+                }
+            }
+        }
+        if (next_arm != current_arm) {
+            suspendArm(current_arm);
+            resumeArm(next_arm);
+            current_arm = next_arm;
+        }
+    }
+
+    int pickVariable(const vector<signed char>& literal_values, int num_unassigned) {
+        run_decisions++;
+        if (current_arm == 0) return vsids.pickVariable(literal_values, num_unassigned);
+        if (current_arm == 1) return lrb.pickVariable(literal_values, num_unassigned);
+        return chb.pickVariable(literal_values, num_unassigned);
+    }
+
+    // the VSIDS arm's scores carry over; LRB and CHB relearn theirs quickly
+    void exportScores(vector<double>& scores) { vsids.exportScores(scores); }
+    void importScores(const vector<double>& scores) { vsids.importScores(scores); }
+};
+
+// -------------------------
+// Restart policies
+// -------------------------
+
+// never restarts
+struct NoRestarts
+{
+    static const char* name() { return "none"; }
+    static const bool has_modes = false;
+
+    void init() {}
+    void setStableMode(bool stable) {}
+    void onLearnedClause(int lbd) {}
+    bool shouldRestart(long long num_conflicts) { return false; }
+};
+
+// restarts after luby(i) * 100 conflicts: 100, 100, 200, 100, 100, 200, 400, ...
+struct LubyRestarts
+{
+    long long restart_count;
+    long long next_restart_conflicts;
+
+    static const char* name() { return "luby"; }
+    static const bool has_modes = false;
+
+    static long long luby(long long i) {
+        // find the finite subsequence that contains index i, and its size
+        long long size = 1;
+        int power = 0;
+        while (size < i + 1) {
+            power++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != i) {
+            size = (size - 1) >> 1;
+            power--;
+            i = i % size;
+        }
+        return 1LL << power;
+    }
+
+    void init() {
+        restart_count = 0;
+        next_restart_conflicts = 100;
+    }
+
+    void setStableMode(bool stable) {}
+    void onLearnedClause(int lbd) {}
+
+    bool shouldRestart(long long num_conflicts) {
+        if (num_conflicts < next_restart_conflicts) return false;
+        restart_count++;
+        next_restart_conflicts = num_conflicts + 100 * luby(restart_count);
+        return true;
+    }
+};
+
+/* focused mode: glucose-style restarts, whenever the LBD of recent learned
+ * clauses (fast moving average) is well above the long-run average, i.e.
+ * the search has drifted into a bad region.
+ * stable mode: reluctant doubling, luby(i) * 1024 conflicts between restarts.
+*/
+struct ModeRestarts
+{
+    bool stable;
+    double fast_lbd_average;
+    double slow_lbd_average;
+    long long num_learned;
+    long long conflicts_since_restart;
+    long long restart_count;
+    long long next_restart_conflicts;  // stable mode only; -1 until the first conflict in the mode
+
+    static const char* name() { return "mode"; }
+    static const bool has_modes = true;
+
+    void init() {
+        stable = false;
+        fast_lbd_average = 0;
+        slow_lbd_average = 0;
+        num_learned = 0;
+        conflicts_since_restart = 0;
+        restart_count = 0;
+        next_restart_conflicts = -1;
+    }
+
+    void setStableMode(bool stable_mode) {
+        stable = stable_mode;
+        conflicts_since_restart = 0;
+        restart_count = 0;
+        next_restart_conflicts = -1;
+    }
+
+    void onLearnedClause(int lbd) {
+        num_learned++;
+        conflicts_since_restart++;
+        // early on the slow average is a plain mean, so it does not start biased towards 0
+        fast_lbd_average += (lbd - fast_lbd_average) / min(32.0, (double) num_learned);
+        slow_lbd_average += (lbd - slow_lbd_average) / min(4096.0, (double) num_learned);
+    }
+
+    bool shouldRestart(long long num_conflicts) {
+        if (stable) {
+            if (next_restart_conflicts < 0) next_restart_conflicts = num_conflicts + 1024;
+            if (num_conflicts < next_restart_conflicts) return false;
+            restart_count++;
+            next_restart_conflicts = num_conflicts + 1024 * LubyRestarts::luby(restart_count);
+            return true;
+        }
+        if (conflicts_since_restart < 2 || fast_lbd_average <= 1.1 * slow_lbd_average) return false;
+        conflicts_since_restart = 0;
+        return true;
+    }
+};
+
+// -------------------------
+// Phase policies
+// -------------------------
+
+// chooses the most frequent polarity to assign true, unless a phase was suggested
+struct PolarityPhase
+{
+    // -1: no suggestion, 0: positive, 1: negative
+    vector<signed char> suggested_phase;
+
+    static const char* name() { return "polarity"; }
+    static const bool has_modes = false;
+
+    void init(int num_variables) {
+        suggested_phase.assign(num_variables, -1);
+    }
+
+    void setStableMode(bool stable) {}
+    void onUnassign(int variable, bool was_negative) {}
+    void onConflict(const vector<Lit>& trail, int conflict_free_size) {}
+
+    void setPhase(int variable, bool is_negative) {
+        suggested_phase[variable] = is_negative;
+    }
+
+    bool pickNegative(int variable, const vector<int>& literal_polarity_difference) {
+        if (suggested_phase[variable] != -1) return suggested_phase[variable];
+        // there are more false literals in the formula currently
+        return literal_polarity_difference[variable] < 0;
+    }
+};
+
+// reuses the polarity a variable last had, falling back to the most frequent one
+struct SavedPhase
+{
+    // -1: never assigned, 0: was positive, 1: was negative
+    vector<signed char> saved_phase;
+
+    static const char* name() { return "saved"; }
+    static const bool has_modes = false;
+
+    void init(int num_variables) {
+        saved_phase.assign(num_variables, -1);
+    }
+
+    void setStableMode(bool stable) {}
+
+    void onUnassign(int variable, bool was_negative) {
+        saved_phase[variable] = was_negative;
+    }
+
+    void onConflict(const vector<Lit>& trail, int conflict_free_size) {}
+
+    void setPhase(int variable, bool is_negative) {
+        saved_phase[variable] = is_negative;
+    }
+
+    bool pickNegative(int variable, const vector<int>& literal_polarity_difference) {
+        if (saved_phase[variable] != -1) return saved_phase[variable];
+        return literal_polarity_difference[variable] < 0;
+    }
+};
+
+/* saved phases in focused mode; in stable mode, the target phases: the
+ * assignment of the longest conflict-free trail prefix seen since the mode began
+*/
+struct TargetPhase
+{
+    // -1: never assigned, 0: positive, 1: negative
+    vector<signed char> saved_phase;
+    vector<signed char> target_phase;
+    int target_size;
+    bool stable;
+
+    static const char* name() { return "target"; }
+    static const bool has_modes = true;
+
+    void init(int num_variables) {
+        saved_phase.assign(num_variables, -1);
+        target_phase.assign(num_variables, -1);
+        target_size = 0;
+        stable = false;
+    }
+
+    void setStableMode(bool stable_mode) {
+        stable = stable_mode;
+        target_size = 0;
+    }
+
+    void onUnassign(int variable, bool was_negative) {
+        saved_phase[variable] = was_negative;
+    }
+
+    void onConflict(const vector<Lit>& trail, int conflict_free_size) {
+        if (!stable || conflict_free_size <= target_size) return;
+        target_size = conflict_free_size;
+        for (int i = 0; i < conflict_free_size; i++) {
+            target_phase[literalVariable(trail[i])] = isNegativeLiteral(trail[i]);
+        }
+    }
+
+    void setPhase(int variable, bool is_negative) {
+        saved_phase[variable] = is_negative;
+    }
+
+    bool pickNegative(int variable, const vector<int>& literal_polarity_difference) {
+        if (stable && target_phase[variable] != -1) return target_phase[variable];
+        if (saved_phase[variable] != -1) return saved_phase[variable];
+        return literal_polarity_difference[variable] < 0;
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef SOLVER_REGISTRY_H
+#define SOLVER_REGISTRY_H
+
+#include <memory>
+#include "CDCLSolver.h"
+#include "SolverPolicies.h"
+#include "LocalSearch.h"
+#include "BruteForce.h"
+#include "LookaheadSolver.h"
+#include "EngineSelection.h"
+
+/* Every policy combination is instantiated here once and registered under
+ * "<branching>-<restart>-<phase>", e.g. "frequency-none-polarity".
+ * Drivers pick one by name at runtime; the chosen instantiation has its
+ * policies inlined into its own search loop.
+ * "vsids-mode-target" alternates focused and stable mode (see SolverPolicies.h);
+ * "bandit-..." lets a UCB1 bandit choose among vsids, lrb and chb at each restart.
+ *
+ * Local search engines are "probsat" and "walksat"; "probsat+<cdcl name>"
+ * runs probSAT first and seeds the CDCL solver's phases with its best assignment.
+ *
+ * "bruteforce" enumerates all assignments of formulas with at most
+ * MAX_BRUTE_FORCE_VARIABLES variables; "bruteforce+<name>" dispatches on the
+ * variable count and hands larger formulas to the named solver.
+ *
+ * "lookahead" is the march-style lookahead DPLL engine.
+ *
+ * "auto" picks one of the above per formula from its features (see
+ * EngineSelection.h) by fixed rules; "auto:<file>" by the nearest instance in
+ * a selector model file.
+*/
+
+typedef unique_ptr<SatSolver> (*SolverFactory)();
+
+struct SolverRegistryEntry
+{
+    string name;
+    SolverFactory create;
+};
+
+template <class Branching, class Restart, class Phase>
+unique_ptr<SatSolver> createCDCLSolver() {
+    return unique_ptr<SatSolver>(new CDCLSolver<Branching, Restart, Phase>());
+}
+
+template <class Branching, class Restart, class Phase>
+void registerCDCLSolver(vector<SolverRegistryEntry>& registry) {
+    string name = string(Branching::name()) + "-" + Restart::name() + "-" + Phase::name();
+    registry.push_back({name, &createCDCLSolver<Branching, Restart, Phase>});
+}
+
+template <class Branching, class Restart>
+void registerPhasePolicies(vector<SolverRegistryEntry>& registry) {
+    registerCDCLSolver<Branching, Restart, PolarityPhase>(registry);
+    registerCDCLSolver<Branching, Restart, SavedPhase>(registry);
+    registerCDCLSolver<Branching, Restart, TargetPhase>(registry);
+}
+
+template <class Branching>
+void registerRestartPolicies(vector<SolverRegistryEntry>& registry) {
+    registerPhasePolicies<Branching, NoRestarts>(registry);
+    registerPhasePolicies<Branching, LubyRestarts>(registry);
+    registerPhasePolicies<Branching, ModeRestarts>(registry);
+}
+
+inline const vector<SolverRegistryEntry>& solverRegistry() {
+    static vector<SolverRegistryEntry> registry;
+    if (registry.empty()) {
+        registerRestartPolicies<FrequencyBranching>(registry);
+        registerRestartPolicies<RandomBranching>(registry);
+        registerRestartPolicies<VSIDSBranching>(registry);
+        registerRestartPolicies<LRBBranching>(registry);
+        registerRestartPolicies<CHBBranching>(registry);
+        registerRestartPolicies<BanditBranching>(registry);
+    }
+    return registry;
+}
+
+// flip budget local search gets before handing over to CDCL
+const long long PHASE_INITIALIZATION_FLIPS = 200000;
+
+// returns nullptr if no solver is registered under that name
+inline unique_ptr<SatSolver> createSolver(const string& name) {
+    if (name == "auto") {
+        return unique_ptr<SatSolver>(new AutoSelectingSolver(unique_ptr<EngineSelector>(new RuleSelector()), &createSolver));
+    }
+    if (name.compare(0, 5, "auto:") == 0) {
+        unique_ptr<NearestNeighbourSelector> selector(new NearestNeighbourSelector());
+        if (!selector->load(name.substr(5))) return nullptr;
+        return unique_ptr<SatSolver>(new AutoSelectingSolver(move(selector), &createSolver));
+    }
+    if (name == "lookahead") {
+        return unique_ptr<SatSolver>(new LookaheadSolver());
+    }
+    if (name == "bruteforce") {
+        return unique_ptr<SatSolver>(new BruteForceSolver());
+    }
+    if (name.compare(0, 11, "bruteforce+") == 0) {
+        unique_ptr<SatSolver> large_instance_solver = createSolver(name.substr(11));
+        if (!large_instance_solver) return nullptr;
+        return unique_ptr<SatSolver>(new SmallInstanceDispatchSolver(move(large_instance_solver)));
+    }
+
+    string local_search_name = name.substr(0, name.find('+'));
+    if (local_search_name == "probsat" || local_search_name == "walksat") {
+        LocalSearchParams params;
+        params.mode = (local_search_name == "probsat") ? LocalSearchMode::probsat : LocalSearchMode::walksat;
+        if (local_search_name == name) {
+            return unique_ptr<SatSolver>(new LocalSearchSolver(params));
+        }
+        unique_ptr<SatSolver> cdcl_solver = createSolver(name.substr(name.find('+') + 1));
+        if (!cdcl_solver) return nullptr;
+        params.max_flips = PHASE_INITIALIZATION_FLIPS;
+        return unique_ptr<SatSolver>(new PhaseInitializedSolver(params, move(cdcl_solver)));
+    }
+
+    const vector<SolverRegistryEntry>& registry = solverRegistry();
+    for (int i = 0; i < registry.size(); i++) {
+        if (registry[i].name == name) return registry[i].create();
+    }
+    return nullptr;
+}
+
+inline void printSolverNames(ostream& out) {
+    const vector<SolverRegistryEntry>& registry = solverRegistry();
+    for (int i = 0; i < registry.size(); i++) {
+        out << registry[i].name << endl;
+    }
+    out << "probsat" << endl;
+    out << "walksat" << endl;
+    out << "probsat+<any name above>" << endl;
+    out << "walksat+<any name above>" << endl;
+    out << "lookahead" << endl;
+    out << "bruteforce" << endl;
+    out << "bruteforce+<any name above>" << endl;
+    out << "auto" << endl;
+    out << "auto:<selector model file>" << endl;
+}
+
+#endif
@@ -0,0 +1,424 @@
+#ifndef SOLVER_SERVER_H
+#define SOLVER_SERVER_H
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include "SolverRegistry.h"
+#include "ResultCache.h"
+
+/* A long running solver process serving requests on a Unix domain socket.
+ * A client connects, writes one request and shuts down its writing side; the
+ * server answers on the same connection and closes it.
+ * A request is a CNF in DIMACS, optionally preceded by one line of options that
+ * starts with "--": --heuristic NAME, --seed N, --model 0|1 (print the model
+ * of a SAT result, default 1), and any budget or search option the Solver
+ * executables take (--conflicts, --time, --reduce, ...). Options left out take
+ * the server's defaults.
+ * The answer is streamed as it is known: the result line (SAT, UNSAT or
+ * UNKNOWN), the model line of a SAT result, then "c ..." statistics lines.
+ * A request that cannot be served gets a single "ERROR ..." line: bad options,
+ * a CNF that does not parse or does not match its p line, more than
+ * MAX_REQUEST_VARIABLES variables or MAX_REQUEST_BYTES bytes, or a solver
+ * running out of memory.
+ *
+ * Connections are queued for a pool of worker threads. Each worker keeps its
+ * solvers (one per heuristic it has been asked for), its request buffer and
+ * its parsed formula from one request to the next, so a warm worker parses
+ * and loads into memory it already owns.
+ *
+ * The workers share a result cache: a request for a formula already answered
+ * gets the cached result (and the statistics of the search that found it,
+ * after a "c cached result" line) without being loaded. Requests for a proof
+ * are always solved.
+*/
+
+const int DEFAULT_SERVER_WORKERS = 4;
+// bytes read from a connection at a time
+const int SERVER_READ_CHUNK = 1 << 16;
+// larger requests are refused instead of letting a worker run out of memory
+const size_t MAX_REQUEST_BYTES = 256 << 20;
+const int MAX_REQUEST_VARIABLES = 1 << 22;
+
+struct ServerParams
+{
+    string socket_path;
+    int num_workers = DEFAULT_SERVER_WORKERS;
+    // defaults for requests that do not set them
+    string heuristic = "frequency-none-polarity";
+    uint64_t seed = 0;
+    SolverBudget budget;
+    SolverOptions options;
+    // results kept in memory across requests (0 keeps none)
+    size_t cache_entries = DEFAULT_CACHE_ENTRIES;
+    // on-disk result cache, shared with other processes; empty uses none
+    string cache_path;
+};
+
+// istream over bytes already in memory, so a request is parsed where it was received
+class MemoryStreamBuffer : public streambuf
+{
+public:
+    MemoryStreamBuffer(char* begin, char* end) { setg(begin, begin, end); }
+};
+
+// ostream buffer writing to a socket; every flush (endl) sends what was written
+class SocketStreamBuffer : public streambuf
+{
+    int socket_fd;
+    char buffer[4096];
+    bool is_broken = false;
+
+    bool sendBuffer() {
+        const char* data = pbase();
+        size_t size = pptr() - pbase();
+        while (size > 0 && !is_broken) {
+            // MSG_NOSIGNAL: a client that went away must not kill the server with SIGPIPE
+            ssize_t sent = send(socket_fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                is_broken = true;
+                break;
+            }
+            data += sent;
+            size -= sent;
+        }
+        setp(buffer, buffer + sizeof(buffer) - 1);
+        return !is_broken;
+    }
+
+protected:
+    int overflow(int c) override {
+        if (c != EOF) {
+            *pptr() = (char) c;
+            pbump(1);
+        }
+        return sendBuffer() ? c : EOF;
+    }
+
+    int sync() override { return sendBuffer() ? 0 : -1; }
+
+public:
+    explicit SocketStreamBuffer(int fd) : socket_fd(fd) { setp(buffer, buffer + sizeof(buffer) - 1); }
+};
+
+class SolverServer
+{
+    struct Worker
+    {
+        thread runner;
+        // warm solvers by heuristic name
+        map<string, unique_ptr<SatSolver>> solvers;
+        vector<char> request;
+        CNFFormula formula;
+        vector<Lit> hints;
+        CachedResult cached;
+        long long num_requests = 0;
+    };
+
+    ServerParams params;
+    int listen_fd = -1;
+    vector<unique_ptr<Worker>> workers;
+    deque<int> pending_connections;
+    bool is_stopping = false;
+    ResultCache cache;
+    mutex connections_mutex;
+    condition_variable has_connection;
+
+    void workerLoop(Worker& worker);
+    void serveConnection(Worker& worker, int connection);
+    bool readRequest(int connection, vector<char>& request);
+
+public:
+    ~SolverServer() { stop(); }
+
+    // binds the socket and starts the workers; false (with a message on cerr) on failure
+    bool start(const ServerParams& server_params);
+    // accepts connections until SIGINT
+    void run();
+    // lets the workers finish what they are serving, then removes the socket
+    void stop();
+};
+
+inline bool SolverServer::start(const ServerParams& server_params) {
+    params = server_params;
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (params.socket_path.empty() || params.socket_path.size() >= sizeof(address.sun_path)) {
+        cerr << "bad socket path " << params.socket_path << endl;
+        return false;
+    }
+    // also fills the solver registry before any worker thread can look a name up
+    if (!createSolver(params.heuristic)) {
+        cerr << "unknown heuristic " << params.heuristic << endl;
+        return false;
+    }
+    cache.setMaxEntries(params.cache_entries);
+    if (!params.cache_path.empty()) cache.openIndex(params.cache_path);
+    strcpy(address.sun_path, params.socket_path.c_str());
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        cerr << "cannot create socket" << endl;
+        return false;
+    }
+    // a socket file left behind by a previous server would make bind fail
+    unlink(params.socket_path.c_str());
+    if (bind(listen_fd, (sockaddr*) &address, sizeof(address)) < 0 || listen(listen_fd, 64) < 0) {
+        cerr << "cannot listen on " << params.socket_path << endl;
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    is_stopping = false;
+    for (int i = 0; i < max(1, params.num_workers); i++) {
+        workers.push_back(unique_ptr<Worker>(new Worker()));
+        Worker& worker = *workers.back();
+        // warm up with the default solver, so the first request does not pay for it
+        worker.solvers[params.heuristic] = createSolver(params.heuristic);
+        worker.runner = thread(&SolverServer::workerLoop, this, ref(worker));
+    }
+    return true;
+}
+
+inline void SolverServer::run() {
+    pollfd listener = {listen_fd, POLLIN, 0};
+    while (!interrupt_signalled) {
+        // wake up now and then to notice SIGINT, which does not interrupt a restarted accept()
+        if (poll(&listener, 1, 200) <= 0) continue;
+        int connection = accept(listen_fd, nullptr, nullptr);
+        if (connection < 0) continue;
+        lock_guard<mutex> guard(connections_mutex);
+        pending_connections.push_back(connection);
+        has_connection.notify_one();
+    }
+}
+
+inline void SolverServer::stop() {
+    if (listen_fd < 0) return;
+    {
+        lock_guard<mutex> guard(connections_mutex);
+        is_stopping = true;
+    }
+    has_connection.notify_all();
+    for (int i = 0; i < workers.size(); i++) workers[i]->runner.join();
+    workers.clear();
+    for (int i = 0; i < pending_connections.size(); i++) close(pending_connections[i]);
+    pending_connections.clear();
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(params.socket_path.c_str());
+}
+
+inline void SolverServer::workerLoop(Worker& worker) {
+    while (true) {
+        int connection;
+        {
+            unique_lock<mutex> guard(connections_mutex);
+            has_connection.wait(guard, [this] { return !pending_connections.empty() || is_stopping; });
+            if (is_stopping) return;
+            connection = pending_connections.front();
+            pending_connections.pop_front();
+        }
+        serveConnection(worker, connection);
+        close(connection);
+        worker.num_requests++;
+    }
+}
+
+/* reads until the client shuts down its side, or past MAX_REQUEST_BYTES;
+ * the buffer keeps its capacity between requests
+*/
+inline bool SolverServer::readRequest(int connection, vector<char>& request) {
+    request.clear();
+    while (request.size() <= MAX_REQUEST_BYTES) {
+        size_t size = request.size();
+        request.resize(size + SERVER_READ_CHUNK);
+        ssize_t received = recv(connection, request.data() + size, SERVER_READ_CHUNK, 0);
+        if (received < 0) {
+            request.resize(size);
+            if (errno == EINTR) continue;
+            return false;
+        }
+        request.resize(size + received);
+        if (received == 0) return true;
+    }
+    return true;
+}
+
+inline void SolverServer::serveConnection(Worker& worker, int connection) {
+    SocketStreamBuffer socket_buffer(connection);
+    ostream out(&socket_buffer);
+    if (!readRequest(connection, worker.request)) return;
+    if (worker.request.size() > MAX_REQUEST_BYTES) {
+        out << "ERROR request larger than " << MAX_REQUEST_BYTES << " bytes" << endl;
+        return;
+    }
+
+    // the options line, if there is one
+    string heuristic = params.heuristic;
+    uint64_t seed = params.seed;
+    SolverBudget budget = params.budget;
+    SolverOptions options = params.options;
+    bool print_model = true;
+    char* begin = worker.request.data();
+    char* end = begin + worker.request.size();
+    if (begin != end && *begin == '-') {
+        char* line_end = find(begin, end, '\n');
+        istringstream line(string(begin, line_end));
+        begin = line_end;
+        string option, value;
+        try {
+            while (line >> option) {
+                if (!(line >> value)) {
+                    out << "ERROR missing value for " << option << endl;
+                    return;
+                }
+                if (option == "--heuristic") heuristic = value;
+                else if (option == "--seed") seed = stoull(value);
+                else if (option == "--model") print_model = stoi(value) != 0;
+                else if (!parseSolveOption(option, value, budget, options)) {
+                    out << "ERROR unknown option " << option << endl;
+                    return;
+                }
+            }
+        } catch (const exception&) {
+            out << "ERROR bad value " << value << " for " << option << endl;
+            return;
+        }
+    }
+
+    unique_ptr<SatSolver>& solver = worker.solvers[heuristic];
+    if (!solver) solver = createSolver(heuristic);
+    if (!solver) {
+        worker.solvers.erase(heuristic);
+        out << "ERROR unknown heuristic " << heuristic << endl;
+        return;
+    }
+    MemoryStreamBuffer request_buffer(begin, end);
+    istream in(&request_buffer);
+    string failure;
+    if (!readDimacsChecked(in, worker.formula, MAX_REQUEST_VARIABLES, failure)) {
+        out << "ERROR bad CNF: " << failure << endl;
+        return;
+    }
+
+    bool use_cache = cache.isEnabled() && options.proof_path.empty();
+    CacheKey key = use_cache ? canonicalFormulaKey(worker.formula) : CacheKey();
+    if (use_cache && cache.lookup(key, worker.formula, worker.cached)) {
+        printCachedResult(worker.cached, print_model, out);
+        out << "c cached result" << endl;
+        printSolverStatistics(worker.cached.statistics, out);
+        return;
+    }
+
+    solver->setSeed(seed);
+    solver->setBudget(budget);
+    solver->setOptions(options);
+    ReturnValue result;
+    try {
+        solver->load(worker.formula);
+        if (!options.hint_path.empty() && readHints(options.hint_path, worker.formula.num_variables, worker.hints)) {
+            solver->suggestAssignment(worker.hints);
+        }
+        result = solver->search();
+    } catch (const bad_alloc&) {
+        // the solver may be left half built: the next request gets a fresh one
+        worker.solvers.erase(heuristic);
+        out << "ERROR out of memory" << endl;
+        return;
+    }
+    if (use_cache) cache.store(key, makeCachedResult(*solver, result));
+    solver->printResult(result, print_model, out);
+    if (solver->getStatistics().proof_write_failed) out << "c proof write failed" << endl;
+    // UNKNOWN results come with their statistics already
+    if (result != ReturnValue::unknown) solver->printStatistics(out);
+}
+
+/* "serve SOCKET [--workers N] [--cache-entries N] [--cache FILE] [request defaults]":
+ * runs the server until SIGINT, with N results cached in memory and, with
+ * --cache, an on-disk result cache.
+ * The defaults are the options a request can set (see above), --heuristic
+ * starting from the executable's own.
+*/
+inline int runServer(int argc, char* argv[], const string& heuristic) {
+    if (argc < 3) {
+        cerr << "usage: serve SOCKET [--workers N] [options]" << endl;
+        return 1;
+    }
+    ServerParams params;
+    params.socket_path = argv[2];
+    params.heuristic = heuristic;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--workers") params.num_workers = stoi(argv[i + 1]);
+        else if (option == "--cache-entries") params.cache_entries = stoull(argv[i + 1]);
+        else if (option == "--cache") params.cache_path = argv[i + 1];
+        else if (option == "--heuristic") params.heuristic = argv[i + 1];
+        else if (option == "--seed") params.seed = stoull(argv[i + 1]);
+        else if (!parseSolveOption(option, argv[i + 1], params.budget, params.options)) cerr << "ignoring unknown option " << option << endl;
+    }
+    // Ctrl-C stops the searches in progress with UNKNOWN, then the server
+    signal(SIGINT, handleInterruptSignal);
+    SolverServer server;
+    if (!server.start(params)) return 1;
+    cerr << "serving on " << params.socket_path << " with " << max(1, params.num_workers) << " workers" << endl;
+    server.run();
+    server.stop();
+    return 0;
+}
+
+/* "client SOCKET [request options]": sends the CNF on stdin as one request and
+ * prints the answer, for scripts and tests on the same machine
+*/
+inline int runClient(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: client SOCKET [options] < CNF" << endl;
+        return 1;
+    }
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    string socket_path = argv[2];
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        cerr << "bad socket path " << socket_path << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, (sockaddr*) &address, sizeof(address)) < 0) {
+        cerr << "cannot connect to " << socket_path << endl;
+        if (connection >= 0) close(connection);
+        return 1;
+    }
+
+    string request;
+    for (int i = 3; i < argc; i++) {
+        request += i == 3 ? "" : " ";
+        request += argv[i];
+    }
+    if (!request.empty()) request += "\n";
+    request.append(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+    {
+        SocketStreamBuffer socket_buffer(connection);
+        ostream out(&socket_buffer);
+        out << request << flush;
+    }
+    shutdown(connection, SHUT_WR);
+
+    char buffer[SERVER_READ_CHUNK];
+    ssize_t received;
+    while ((received = recv(connection, buffer, sizeof(buffer), 0)) > 0) cout.write(buffer, received);
+    close(connection);
+    return 0;
+}
+
+#endif